@@ -61,23 +61,39 @@ lang                = en
 
 EXEC                = egz
 
+#-------------------------------------------------------------------------------
+# Benchmark executable (not part of the default build, see "make bench")
+#-------------------------------------------------------------------------------
+
+BENCH               = egz-bench
+BENCH_ARGS          = 
+
+#-------------------------------------------------------------------------------
+# Trace level (0: none, 1: per-block events, 2: per-symbol events)
+#-------------------------------------------------------------------------------
+
+TRACE               = 0
+
 #-------------------------------------------------------------------------------
 # Dependancies for the executables (objects)
 #-------------------------------------------------------------------------------
 
-DEPS_egz            = args btree compress debug error expand file help md5 symbols
+DEPS_egz            = archive args batch bitstream block buffer btree checksum compress debug error expand file files help lookup pool progress scheduler stats symbols table trace
+DEPS_egz-bench      = $(DEPS_egz)
 
 #-------------------------------------------------------------------------------
 # Dependancies for the executables (libraries)
 #-------------------------------------------------------------------------------
 
 DEPS_LIB_egz        = libdebug libio libprogressbar
+DEPS_LIB_egz-bench  = $(DEPS_LIB_egz)
 
 #-------------------------------------------------------------------------------
 # Dependancies for the executables (system libraries)
 #-------------------------------------------------------------------------------
 
-DEPS_SYSLIB_egz     = crypto
+DEPS_SYSLIB_egz     = crypto pthread
+DEPS_SYSLIB_egz-bench = $(DEPS_SYSLIB_egz)
 
 #-------------------------------------------------------------------------------
 # Used frameworks (relevant only for Objective-C)
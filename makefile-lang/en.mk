@@ -61,11 +61,12 @@ LANG_EXEC_START          := Finding and building the executables
 LANG_EXEC_END            := All executables were processed
 LANG_CLEAN_START         := Removing all the build files in _DIR_BUILD_
 LANG_NOSCRIPT_UNINSTALL  := Sorry, but there\'s actually no uninstall script
-LANG_NOSCRIPT_TEST       := Sorry, but there\'s actually no test script
+LANG_TEST_RUN            := Checking the batch API with _TFILE_
 LANG_NOSCRIPT_INFOS      := You should find your build files and binaries in _DIR_BUILD_
 LANG_O_BUILD             := Building the object file for _CFILE_ in _DIR_BUILD_
 LANG_LO_BUILD            := Building the library object file for _CFILE_ in _DIR_BUILD_
 LANG_LA_BUILD            := Building the library archive file for _TNAME_ in _DIR_BUILD_
+LANG_BENCH_RUN           := Running _TFILE_ - the results will be written in _OFILE_
 LANG_DEPS_FIND           := Finding dependancies for _TFILE_
 LANG_DEPS_LIB_FIND       := Finding local library dependancies for _TFILE_
 LANG_DEPS_SYSLIB_FIND    := Finding system dependancies for _TFILE_
@@ -61,11 +61,12 @@ LANG_EXEC_START          := Recherche et génération des exécutables
 LANG_EXEC_END            := Tous les exécutables ont été traités
 LANG_CLEAN_START         := Effacement des fichiers générés dans _DIR_BUILD_
 LANG_NOSCRIPT_UNINSTALL  := Désolé, mais il n\'y a actuellement aucun script de désinstallation
-LANG_NOSCRIPT_TEST       := Désolé, mais il n\'y a actuellement aucun script de test
+LANG_TEST_RUN            := Vérification de l\'API de lots avec _TFILE_
 LANG_NOSCRIPT_INFOS      := Vous devriez trouver les fichiers générés et les binaires dans _DIR_BUILD_
 LANG_O_BUILD             := Génération du fichier objet pour _CFILE_ dans _DIR_BUILD_
 LANG_LO_BUILD            := Génération du fichier objet de librairie pour _CFILE_ dans _DIR_BUILD_
 LANG_LA_BUILD            := Génération du fichier archive de librairie pour _TNAME_ dans _DIR_BUILD_
+LANG_BENCH_RUN           := Exécution de _TFILE_ - les résultats seront écrits dans _OFILE_
 LANG_DEPS_FIND           := Recherche des dépendances pour _TFILE_
 LANG_DEPS_LIB_FIND       := Finding local library dependancies for _TFILE_
 LANG_DEPS_SYSLIB_FIND    := Recherche des dépendances de librairies locales pour _TFILE_
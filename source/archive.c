@@ -0,0 +1,776 @@
+/*******************************************************************************
+ * Copyright (c) 2010, Jean-David Gadina - www.xs-labs.com
+ * Distributed under the Boost Software License, Version 1.0.
+ * 
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ * 
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ * 
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ******************************************************************************/
+
+/* $Id$ */
+
+/*!
+ * @file        archive.c
+ * @copyright   (c) 2011 - Jean-David Gadina - www.xs-labs.com
+ * @abstract    Multi-member archives, with a central index
+ */
+
+/* Local includes */
+#include "egz.h"
+
+/* System includes */
+#include <errno.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* Private functions */
+static egz_status egz_archive_check_names( egz_files * files, size_t * count, unsigned long * failures );
+static int        egz_archive_compare_names( const void * task1_ptr, const void * task2_ptr );
+static egz_status egz_archive_task( egz_task * task, void * context );
+static egz_status egz_archive_append( FILE * archive, egz_task * task, egz_archive_entry * entry );
+static void       egz_archive_write( FILE * archive, void * data, size_t length, uint32_t * crc );
+static bool       egz_archive_read( FILE * archive, void * data, size_t length, uint32_t * crc );
+static char     * egz_archive_member_name( char * path );
+static bool       egz_archive_is_safe( char * name );
+static bool       egz_archive_create_directories( char * path );
+
+/*!
+ * 
+ */
+egz_status egz_archive_create( char * filename, egz_files * files, egz_options * options, unsigned int threads, unsigned long * failures )
+{
+    uint32_t              i;
+    uint32_t              crc;
+    uint16_t              length;
+    uint8_t               type;
+    uint64_t              offset;
+    size_t                count;
+    FILE                * archive;
+    egz_task            * task;
+    egz_scheduler       * scheduler;
+    egz_archive_entry   * entries;
+    egz_archive_context   context;
+    egz_status            status;
+    struct stat           info;
+    
+    /* The index counts its members on 32 bits */
+    if( files->count > 0xFFFFFFFF )
+    {
+        return EGZ_ERROR_INVALID_INDEX;
+    }
+    
+    /* The members that could not be extracted safely are left out before anything is compressed */
+    if( EGZ_OK != ( status = egz_archive_check_names( files, &count, failures ) ) )
+    {
+        return status;
+    }
+    
+    if( NULL == ( entries = ( egz_archive_entry * )calloc( ( count > 0 ) ? count : 1, sizeof( egz_archive_entry ) ) ) )
+    {
+        return EGZ_ERROR_MALLOC;
+    }
+    
+    if( NULL == ( archive = fopen( filename, "wb" ) ) || fstat( fileno( archive ), &info ) != 0 )
+    {
+        if( archive != NULL )
+        {
+            fclose( archive );
+        }
+        
+        free( entries );
+        return EGZ_ERROR_FILE;
+    }
+    
+    /* The archive itself may be in the archived tree */
+    context.options = *( options );
+    context.device  = info.st_dev;
+    context.inode   = info.st_ino;
+    
+    fwrite( EGZ_ARCHIVE_ID, sizeof( char ), strlen( EGZ_ARCHIVE_ID ), archive );
+    
+    /* The members are compressed in parallel, and appended in the completion order */
+    if( NULL == ( scheduler = egz_scheduler_create( files->tasks, count, threads, egz_archive_task, &context ) ) )
+    {
+        fclose( archive );
+        remove( filename );
+        free( entries );
+        return EGZ_ERROR_MALLOC;
+    }
+    
+    i = 0;
+    
+    while( NULL != ( task = egz_scheduler_collect( scheduler ) ) )
+    {
+        if( task->status == EGZ_OK )
+        {
+            task->status = egz_archive_append( archive, task, &( entries[ i ] ) );
+        }
+        
+        free( task->output );
+        
+        task->output = NULL;
+        
+        if( task->status == EGZ_OK )
+        {
+            printf
+            (
+                "%s (%.2f MB -> %.2f MB)\n",
+                entries[ i ].name,
+                ( ( double )entries[ i ].original_length / ( double )1000 ) / ( double )1000,
+                ( ( double )entries[ i ].length / ( double )1000 ) / ( double )1000
+            );
+            
+            i++;
+        }
+        else
+        {
+            fprintf( stderr, "Error: Unable to compress file %s. Reason: %s.\n", task->path, egz_error_str( task->status ) );
+            
+            ( *( failures ) )++;
+        }
+    }
+    
+    egz_scheduler_destroy( scheduler );
+    
+    /* Central index - Each member can be found with a single seek */
+    offset = ( uint64_t )ftell( archive );
+    crc    = 0;
+    
+    for( i = 0; i < count && entries[ i ].name != NULL; i++ )
+    {
+        length = ( uint16_t )strlen( entries[ i ].name );
+        type   = ( uint8_t )entries[ i ].checksum_type;
+        
+        egz_archive_write( archive, &length,                           sizeof( uint16_t ),  &crc );
+        egz_archive_write( archive, entries[ i ].name,                 length,              &crc );
+        egz_archive_write( archive, &( entries[ i ].original_length ), sizeof( uint64_t ),  &crc );
+        egz_archive_write( archive, &( entries[ i ].offset ),          sizeof( uint64_t ),  &crc );
+        egz_archive_write( archive, &( entries[ i ].length ),          sizeof( uint64_t ),  &crc );
+        egz_archive_write( archive, &type,                             sizeof( uint8_t ),   &crc );
+        egz_archive_write( archive, entries[ i ].checksum,             EGZ_CHECKSUM_LENGTH, &crc );
+    }
+    
+    /* Trailer - Where the index starts, its number of members and its CRC */
+    fwrite( EGZ_ARCHIVE_INDEX_ID, sizeof( char ),     strlen( EGZ_ARCHIVE_INDEX_ID ), archive );
+    fwrite( &offset,              sizeof( uint64_t ), 1,                              archive );
+    fwrite( &i,                   sizeof( uint32_t ), 1,                              archive );
+    fwrite( &crc,                 sizeof( uint32_t ), 1,                              archive );
+    
+    free( entries );
+    
+    if( fclose( archive ) != 0 )
+    {
+        remove( filename );
+        return EGZ_ERROR_FILE;
+    }
+    
+    return EGZ_OK;
+}
+
+/*!
+ * 
+ */
+egz_status egz_archive_open( char * filename, egz_archive * archive )
+{
+    uint32_t            i;
+    uint32_t            crc;
+    uint32_t            checksum;
+    uint16_t            length;
+    uint8_t             type;
+    uint64_t            offset;
+    uint64_t            size;
+    egz_archive_entry * entry;
+    char                id[ 4 ];
+    unsigned char       trailer[ EGZ_ARCHIVE_TRAILER_LENGTH ];
+    
+    archive->entries = NULL;
+    archive->count   = 0;
+    
+    if( NULL == ( archive->fp = fopen( filename, "rb" ) ) )
+    {
+        return EGZ_ERROR_FILE;
+    }
+    
+    memset( id, 0, sizeof( id ) );
+    
+    /* The trailer tells where the index is - The members are not read */
+    if
+    (
+           fread( id, sizeof( char ), strlen( EGZ_ARCHIVE_ID ), archive->fp ) != strlen( EGZ_ARCHIVE_ID )
+        || strcmp( id, EGZ_ARCHIVE_ID ) != 0
+        || fseek( archive->fp, -EGZ_ARCHIVE_TRAILER_LENGTH, SEEK_END ) != 0
+        || fread( trailer, sizeof( unsigned char ), EGZ_ARCHIVE_TRAILER_LENGTH, archive->fp ) != EGZ_ARCHIVE_TRAILER_LENGTH
+        || memcmp( trailer, EGZ_ARCHIVE_INDEX_ID, strlen( EGZ_ARCHIVE_INDEX_ID ) ) != 0
+    )
+    {
+        egz_archive_close( archive );
+        return EGZ_ERROR_INVALID_FORMAT;
+    }
+    
+    memcpy( &offset,             trailer + 3,  sizeof( uint64_t ) );
+    memcpy( &( archive->count ), trailer + 11, sizeof( uint32_t ) );
+    memcpy( &checksum,           trailer + 15, sizeof( uint32_t ) );
+    
+    /* The trailer ends the file - The index must fit between the archive ID and the trailer, before anything is allocated */
+    size = ( uint64_t )ftell( archive->fp ) - EGZ_ARCHIVE_TRAILER_LENGTH;
+    
+    if
+    (
+           offset < strlen( EGZ_ARCHIVE_ID )
+        || offset > size
+        || archive->count > ( size - offset ) / EGZ_ARCHIVE_ENTRY_MIN_LENGTH
+        || fseek( archive->fp, ( long )offset, SEEK_SET ) != 0
+    )
+    {
+        egz_archive_close( archive );
+        return EGZ_ERROR_INVALID_FORMAT;
+    }
+    
+    if( NULL == ( archive->entries = ( egz_archive_entry * )calloc( ( archive->count > 0 ) ? archive->count : 1, sizeof( egz_archive_entry ) ) ) )
+    {
+        egz_archive_close( archive );
+        return EGZ_ERROR_MALLOC;
+    }
+    
+    crc = 0;
+    
+    for( i = 0; i < archive->count; i++ )
+    {
+        entry = &( archive->entries[ i ] );
+        
+        if( egz_archive_read( archive->fp, &length, sizeof( uint16_t ), &crc ) == false || NULL == ( entry->name = ( char * )calloc( ( size_t )length + 1, sizeof( char ) ) ) )
+        {
+            egz_archive_close( archive );
+            return EGZ_ERROR_INVALID_FORMAT;
+        }
+        
+        if
+        (
+               egz_archive_read( archive->fp, entry->name,                 length,              &crc ) == false
+            || egz_archive_read( archive->fp, &( entry->original_length ), sizeof( uint64_t ),  &crc ) == false
+            || egz_archive_read( archive->fp, &( entry->offset ),          sizeof( uint64_t ),  &crc ) == false
+            || egz_archive_read( archive->fp, &( entry->length ),          sizeof( uint64_t ),  &crc ) == false
+            || egz_archive_read( archive->fp, &type,                       sizeof( uint8_t ),   &crc ) == false
+            || egz_archive_read( archive->fp, entry->checksum,             EGZ_CHECKSUM_LENGTH, &crc ) == false
+        )
+        {
+            egz_archive_close( archive );
+            return EGZ_ERROR_INVALID_FORMAT;
+        }
+        
+        entry->checksum_type                       = type;
+        entry->checksum[ EGZ_CHECKSUM_LENGTH - 1 ] = 0;
+    }
+    
+    if( crc != checksum )
+    {
+        egz_archive_close( archive );
+        return EGZ_ERROR_INVALID_CHECKSUM;
+    }
+    
+    return EGZ_OK;
+}
+
+/*!
+ * 
+ */
+void egz_archive_close( egz_archive * archive )
+{
+    uint32_t i;
+    
+    if( archive->entries != NULL )
+    {
+        for( i = 0; i < archive->count; i++ )
+        {
+            free( archive->entries[ i ].name );
+        }
+    }
+    
+    if( archive->fp != NULL )
+    {
+        fclose( archive->fp );
+    }
+    
+    free( archive->entries );
+    
+    archive->fp      = NULL;
+    archive->entries = NULL;
+    archive->count   = 0;
+}
+
+/*!
+ * 
+ */
+void egz_archive_list( egz_archive * archive )
+{
+    uint32_t            i;
+    egz_archive_entry * entry;
+    
+    printf( "%14s %14s %-7s %-16s %s\n", "Size", "Compressed", "Check", "Checksum", "Name" );
+    
+    for( i = 0; i < archive->count; i++ )
+    {
+        entry = &( archive->entries[ i ] );
+        
+        printf
+        (
+            "%14llu %14llu %-7s %-16s %s\n",
+            ( unsigned long long )entry->original_length,
+            ( unsigned long long )entry->length,
+            egz_get_checksum_name( entry->checksum_type ),
+            entry->checksum,
+            entry->name
+        );
+    }
+}
+
+/*!
+ * 
+ */
+egz_status egz_archive_extract( egz_archive * archive, char ** names, unsigned int count, egz_options * options, unsigned long * failures )
+{
+    uint32_t            i;
+    unsigned int        j;
+    unsigned int        suffix;
+    bool              * found;
+    FILE              * destination;
+    egz_archive_entry * entry;
+    egz_status          status;
+    char                filename[ FILENAME_MAX ];
+    
+    if( NULL == ( found = ( bool * )calloc( ( count > 0 ) ? count : 1, sizeof( bool ) ) ) )
+    {
+        return EGZ_ERROR_MALLOC;
+    }
+    
+    for( i = 0; i < archive->count; i++ )
+    {
+        entry = &( archive->entries[ i ] );
+        
+        /* Only the requested members, or all of them */
+        for( j = 0; j < count && strcmp( egz_archive_member_name( names[ j ] ), entry->name ) != 0; j++ );
+        
+        if( count > 0 && j == count )
+        {
+            continue;
+        }
+        
+        if( count > 0 )
+        {
+            found[ j ] = true;
+        }
+        
+        destination = NULL;
+        status      = EGZ_OK;
+        
+        /* An existing file is kept - The member is written with a suffix, as for a single file */
+        strncpy( filename, entry->name, FILENAME_MAX - 1 );
+        
+        filename[ FILENAME_MAX - 1 ] = 0;
+        
+        for( suffix = 1; access( filename, F_OK ) == 0; suffix++ )
+        {
+            snprintf( filename, FILENAME_MAX, "%s-%u", entry->name, suffix );
+        }
+        
+        /* A member is never written outside of the current directory */
+        if( egz_archive_is_safe( entry->name ) == false || egz_archive_create_directories( filename ) == false )
+        {
+            status = EGZ_ERROR_FILE;
+        }
+        
+        /* An empty member only creates its file */
+        else if( entry->length == 0 )
+        {
+            destination = fopen( filename, "wb" );
+            status      = ( destination != NULL ) ? EGZ_OK : EGZ_ERROR_FILE;
+        }
+        
+        else if( NULL == ( destination = fopen( filename, "wb" ) ) )
+        {
+            status = EGZ_ERROR_FILE;
+        }
+        
+        /* The member is expanded in place - A single seek, from the offset in the index */
+        else if( fseek( archive->fp, ( long )entry->offset, SEEK_SET ) != 0 )
+        {
+            status = EGZ_ERROR_INVALID_FORMAT;
+        }
+        else
+        {
+            status = egz_expand( archive->fp, destination, options );
+        }
+        
+        if( destination != NULL )
+        {
+            fclose( destination );
+            
+            if( status != EGZ_OK )
+            {
+                remove( filename );
+            }
+        }
+        
+        if( status == EGZ_OK )
+        {
+            printf( "%s -> %s (%.2f MB)\n", entry->name, filename, ( ( double )entry->original_length / ( double )1000 ) / ( double )1000 );
+        }
+        else
+        {
+            fprintf( stderr, "Error: Unable to expand member %s. Reason: %s.\n", entry->name, egz_error_str( status ) );
+            
+            ( *( failures ) )++;
+        }
+    }
+    
+    for( j = 0; j < count; j++ )
+    {
+        if( found[ j ] == false )
+        {
+            fprintf( stderr, "Error: No such member in the archive: %s\n", names[ j ] );
+            
+            ( *( failures ) )++;
+        }
+    }
+    
+    free( found );
+    
+    return EGZ_OK;
+}
+
+/*!
+ * 
+ */
+static egz_status egz_archive_check_names( egz_files * files, size_t * count, unsigned long * failures )
+{
+    size_t      i;
+    size_t      j;
+    char      * name;
+    egz_task ** sorted;
+    egz_task    task;
+    
+    *( count ) = 0;
+    
+    if( files->count == 0 )
+    {
+        return EGZ_OK;
+    }
+    
+    if( NULL == ( sorted = ( egz_task ** )malloc( files->count * sizeof( egz_task * ) ) ) )
+    {
+        return EGZ_ERROR_MALLOC;
+    }
+    
+    for( i = 0; i < files->count; i++ )
+    {
+        sorted[ i ] = &( files->tasks[ i ] );
+    }
+    
+    /* Sorted by name, so the members with the same name are next to each other (the first one given is kept) */
+    qsort( sorted, files->count, sizeof( egz_task * ), egz_archive_compare_names );
+    
+    for( i = 0; i < files->count; i++ )
+    {
+        name = egz_archive_member_name( sorted[ i ]->path );
+        
+        if( egz_archive_is_safe( name ) == false || strlen( name ) > 0xFFFF )
+        {
+            fprintf( stderr, "Error: Invalid member name: %s\n", sorted[ i ]->path );
+        }
+        else if( i > 0 && strcmp( name, egz_archive_member_name( sorted[ i - 1 ]->path ) ) == 0 )
+        {
+            fprintf( stderr, "Error: Duplicate member name: %s (%s is already in the archive)\n", sorted[ i ]->path, sorted[ i - 1 ]->path );
+        }
+        else
+        {
+            continue;
+        }
+        
+        sorted[ i ]->status = EGZ_ERROR_FILE;
+        
+        ( *( failures ) )++;
+    }
+    
+    free( sorted );
+    
+    /* The members to compress are moved first, in the same order - Only those are scheduled */
+    for( i = 0, j = 0; i < files->count; i++ )
+    {
+        if( files->tasks[ i ].status != EGZ_OK )
+        {
+            continue;
+        }
+        
+        if( i != j )
+        {
+            task                = files->tasks[ j ];
+            files->tasks[ j ]   = files->tasks[ i ];
+            files->tasks[ i ]   = task;
+        }
+        
+        j++;
+    }
+    
+    *( count ) = j;
+    
+    return EGZ_OK;
+}
+
+/*!
+ * 
+ */
+static int egz_archive_compare_names( const void * task1_ptr, const void * task2_ptr )
+{
+    egz_task * task1;
+    egz_task * task2;
+    int        result;
+    
+    task1 = *( ( egz_task ** )task1_ptr );
+    task2 = *( ( egz_task ** )task2_ptr );
+    
+    if( 0 != ( result = strcmp( egz_archive_member_name( task1->path ), egz_archive_member_name( task2->path ) ) ) )
+    {
+        return result;
+    }
+    
+    /* Same name - The order of the command line */
+    return ( task1 < task2 ) ? -1 : ( ( task1 > task2 ) ? 1 : 0 );
+}
+
+/*!
+ * 
+ */
+static egz_status egz_archive_task( egz_task * task, void * context )
+{
+    size_t                length;
+    unsigned char       * output;
+    FILE                * source;
+    egz_archive_context * archive;
+    egz_context         * codec;
+    egz_mapping           mapping;
+    egz_status            status;
+    struct stat           info;
+    
+    archive = ( egz_archive_context * )context;
+    
+    if( NULL == ( source = fopen( task->path, "rb" ) ) )
+    {
+        return EGZ_ERROR_FILE;
+    }
+    
+    /* The archive being written is not one of its members */
+    if( fstat( fileno( source ), &info ) != 0 || ( info.st_dev == archive->device && info.st_ino == archive->inode ) )
+    {
+        fclose( source );
+        return EGZ_ERROR_FILE;
+    }
+    
+    /* An empty file has no stream - Only its entry is written */
+    if( info.st_size == 0 )
+    {
+        fclose( source );
+        
+        task->output_size = 0;
+        
+        return EGZ_OK;
+    }
+    
+    /* The mapping outlives the file handle */
+    if( egz_map_file( source, &mapping ) == false )
+    {
+        fclose( source );
+        return EGZ_ERROR_FILE;
+    }
+    
+    fclose( source );
+    
+    if( NULL == ( codec = egz_context_create( &( archive->options ) ) ) )
+    {
+        egz_unmap_file( &mapping );
+        return EGZ_ERROR_MALLOC;
+    }
+    
+    length = egz_compress_bound( codec, mapping.length );
+    
+    /* Each member is compressed in memory, and written to the archive once by the collecting thread */
+    if( NULL == ( output = ( unsigned char * )malloc( length ) ) )
+    {
+        egz_context_destroy( codec );
+        egz_unmap_file( &mapping );
+        return EGZ_ERROR_MALLOC;
+    }
+    
+    status = egz_compress_buffer( codec, mapping.data, mapping.length, output, length, &length );
+    
+    egz_context_destroy( codec );
+    egz_unmap_file( &mapping );
+    
+    if( status != EGZ_OK )
+    {
+        free( output );
+        return status;
+    }
+    
+    task->output      = output;
+    task->output_size = length;
+    
+    return EGZ_OK;
+}
+
+/*!
+ * 
+ */
+static egz_status egz_archive_append( FILE * archive, egz_task * task, egz_archive_entry * entry )
+{
+    egz_header header;
+    
+    /* The name was checked before the member was compressed */
+    entry->name   = egz_archive_member_name( task->path );
+    entry->offset = ( uint64_t )ftell( archive );
+    entry->length = task->output_size;
+    
+    /* An empty member - Nothing is stored */
+    if( task->output == NULL )
+    {
+        entry->original_length = 0;
+        entry->checksum_type   = EGZ_CHECKSUM_NONE;
+        
+        memset( entry->checksum, 0, EGZ_CHECKSUM_LENGTH );
+        
+        return EGZ_OK;
+    }
+    
+    /* The size and checksum of the member come from its own header */
+    if( egz_read_header( task->output, ( size_t )task->output_size, &header ) != EGZ_OK )
+    {
+        entry->name = NULL;
+        
+        return EGZ_ERROR_INVALID_FORMAT;
+    }
+    
+    entry->original_length = header.original_length;
+    entry->checksum_type   = header.checksum_type;
+    
+    memcpy( entry->checksum, header.checksum, EGZ_CHECKSUM_LENGTH );
+    
+    entry->checksum[ EGZ_CHECKSUM_LENGTH - 1 ] = 0;
+    
+    if( fwrite( task->output, sizeof( unsigned char ), ( size_t )task->output_size, archive ) != task->output_size )
+    {
+        entry->name = NULL;
+        
+        return EGZ_ERROR_FILE;
+    }
+    
+    return EGZ_OK;
+}
+
+/*!
+ * 
+ */
+static void egz_archive_write( FILE * archive, void * data, size_t length, uint32_t * crc )
+{
+    fwrite( data, sizeof( unsigned char ), length, archive );
+    
+    *( crc ) = egz_crc32c( *( crc ), ( unsigned char * )data, length );
+}
+
+/*!
+ * 
+ */
+static bool egz_archive_read( FILE * archive, void * data, size_t length, uint32_t * crc )
+{
+    if( fread( data, sizeof( unsigned char ), length, archive ) != length )
+    {
+        return false;
+    }
+    
+    *( crc ) = egz_crc32c( *( crc ), ( unsigned char * )data, length );
+    
+    return true;
+}
+
+/*!
+ * 
+ */
+static char * egz_archive_member_name( char * path )
+{
+    /* Members are relative - The leading slashes and current directories are not stored */
+    while( path[ 0 ] == '/' || ( path[ 0 ] == '.' && path[ 1 ] == '/' ) )
+    {
+        path += ( path[ 0 ] == '/' ) ? 1 : 2;
+    }
+    
+    return path;
+}
+
+/*!
+ * 
+ */
+static bool egz_archive_is_safe( char * name )
+{
+    char * component;
+    
+    if( name[ 0 ] == 0 || name[ 0 ] == '/' )
+    {
+        return false;
+    }
+    
+    /* No parent directory component */
+    for( component = name; component != NULL; component = strchr( component, '/' ) )
+    {
+        component += ( component[ 0 ] == '/' ) ? 1 : 0;
+        
+        if( strncmp( component, "..", 2 ) == 0 && ( component[ 2 ] == '/' || component[ 2 ] == 0 ) )
+        {
+            return false;
+        }
+    }
+    
+    return true;
+}
+
+/*!
+ * 
+ */
+static bool egz_archive_create_directories( char * path )
+{
+    char * slash;
+    
+    /* Each parent directory is created in turn, as the path is cut at its slashes */
+    for( slash = strchr( path, '/' ); slash != NULL; slash = strchr( slash + 1, '/' ) )
+    {
+        *( slash ) = 0;
+        
+        if( mkdir( path, 0755 ) != 0 && errno != EEXIST )
+        {
+            *( slash ) = '/';
+            
+            return false;
+        }
+        
+        *( slash ) = '/';
+    }
+    
+    return true;
+}
@@ -38,81 +38,268 @@
 /* Local includes */
 #include "egz.h"
 
+/* Private functions */
+static void   egz_get_cli_option( int argc, char *** argv, int * i, egz_cli_args * args );
+static char * egz_get_cli_value( char * option, char * name, int argc, char *** argv, int * i );
+
 /*!
  * 
  */
 void egz_get_cli_args( int argc, char ** argv, egz_cli_args * args )
 {
-    int    i;
-    char * option;
+    int     i;
+    char ** sources;
     
     /* Default arguments values */
-    args->compress    = false;
-    args->expand      = false;
-    args->force       = false;
-    args->version     = false;
-    args->help        = false;
-    args->debug       = false;
-    args->source      = NULL;
+    args->compress      = false;
+    args->expand        = false;
+    args->force         = false;
+    args->version       = false;
+    args->help          = false;
+    args->debug         = false;
+    args->max_code_bits = EGZ_MAX_CODE_BITS_DEFAULT;
+    args->streams       = EGZ_STREAMS_DEFAULT;
+    args->block_size    = EGZ_BLOCK_SIZE_DEFAULT;
+    args->threads       = EGZ_THREADS_DEFAULT;
+    args->to_stdout     = false;
+    args->train         = false;
+    args->adaptive      = false;
+    args->recursive     = false;
+    args->list          = false;
+    args->output        = NULL;
+    args->table         = NULL;
+    args->check         = NULL;
+    args->stats         = NULL;
+    args->progress_fd   = NULL;
+    args->files_from    = NULL;
+    args->archive       = NULL;
+    args->source        = NULL;
+    args->sources       = NULL;
+    args->source_count  = 0;
     
     i = 0;
     
-    /* Process each CLI argument beginning with a '-' */
-    while( ++i < argc && ( ( char * )*( ++argv ) )[ 0 ] == '-' )
+    /* Process each CLI argument beginning with a '-' (a single '-' is the standard input) */
+    while( ++i < argc && ( ( char * )*( ++argv ) )[ 0 ] == '-' && ( ( char * )*( argv ) )[ 1 ] != 0 )
     {
-        /* Checks the next character */
-        switch( ( ( char * )*( argv ) )[ 1 ] )
+        egz_get_cli_option( argc, &argv, &i, args );
+    }
+    
+    sources = argv;
+    
+    /* Remaining arguments are the source files - Options may still follow them (egz -c FILES -T 2, --train FILES -o TABLE) */
+    for( ; i < argc; i++, argv++ )
+    {
+        if( ( *( argv ) )[ 0 ] == '-' && ( *( argv ) )[ 1 ] != 0 )
         {
-            /* Short form arguments */
-            case 'c': args->compress = true; break;
-            case 'x': args->expand   = true; break;
-            case 'f': args->force    = true; break;
-            case 'v': args->version  = true; break;
-            case 'h': args->help     = true; break;
-            case 'd': args->debug    = true; break;
+            egz_get_cli_option( argc, &argv, &i, args );
+        }
+        else
+        {
+            sources[ args->source_count++ ] = *( argv );
+        }
+    }
+    
+    /* Stores the source file */
+    if( args->source_count > 0 )
+    {
+        args->source  = sources[ 0 ];
+        args->sources = sources;
+    }
+}
+
+/*!
+ * 
+ */
+static void egz_get_cli_option( int argc, char *** argv, int * i, egz_cli_args * args )
+{
+    char * argument;
+    char * option;
+    char * value;
+    
+    argument = *( *( argv ) );
+    
+    /* Checks the next character */
+    switch( argument[ 1 ] )
+    {
+        /* Short form arguments */
+        case 'c': args->compress = true; break;
+        case 'x': args->expand   = true; break;
+        case 'f': args->force    = true; break;
+        case 'v': args->version  = true; break;
+        case 'h': args->help     = true; break;
+        case 'd': args->debug    = true; break;
+        case 's': args->to_stdout = true; break;
+        case 'r': args->recursive = true; break;
+        case 'l': args->list      = true; break;
+        
+        /* Number of threads (-T N or -TN) */
+        case 'T':
             
-            /* Long form arguments */
-            case '-':
-                
-                /* Gets the argument name */
-                option = *( argv ) + 1;
-                
-                /* Checks the argument name */
-                if( strcmp( option, "compress" ) == 0 )
-                {
-                    args->compress = true;
-                }
-                else if( strcmp( option, "expand" ) == 0 )
-                {
-                    args->expand = true;
-                }
-                else if( strcmp( option, "force" ) == 0 )
-                {
-                    args->force = true;
-                }
-                else if( strcmp( option, "version" ) == 0 )
-                {
-                    args->version = true;
-                }
-                else if( strcmp( option, "help" ) == 0 )
-                {
-                    args->help = true;
-                }
-                else if( strcmp( option, "debug" ) == 0 )
-                {
-                    args->debug = true;
-                }
+            if( argument[ 2 ] != 0 )
+            {
+                args->threads = ( unsigned int )strtoul( argument + 2, NULL, 10 );
+            }
+            else if( *( i ) + 1 < argc )
+            {
+                ( *( i ) )++;
                 
-            default:
+                args->threads = ( unsigned int )strtoul( *( ++( *( argv ) ) ), NULL, 10 );
+            }
+            
+            break;
+        
+        /* Output file (-o FILE) */
+        case 'o':
+            
+            if( *( i ) + 1 < argc )
+            {
+                ( *( i ) )++;
                 
-                break;
-        }
+                args->output = *( ++( *( argv ) ) );
+            }
+            
+            break;
+        
+        /* Long form arguments */
+        case '-':
+            
+            /* Gets the argument name (without the dashes) */
+            option = argument + 2;
+            
+            /* Checks the argument name */
+            if( strcmp( option, "compress" ) == 0 )
+            {
+                args->compress = true;
+            }
+            else if( strcmp( option, "expand" ) == 0 )
+            {
+                args->expand = true;
+            }
+            else if( strcmp( option, "force" ) == 0 )
+            {
+                args->force = true;
+            }
+            else if( strcmp( option, "version" ) == 0 )
+            {
+                args->version = true;
+            }
+            else if( strcmp( option, "help" ) == 0 )
+            {
+                args->help = true;
+            }
+            else if( strcmp( option, "debug" ) == 0 )
+            {
+                args->debug = true;
+            }
+            else if( strcmp( option, "stdout" ) == 0 )
+            {
+                args->to_stdout = true;
+            }
+            else if( strcmp( option, "train" ) == 0 )
+            {
+                args->train = true;
+            }
+            else if( strcmp( option, "adaptive" ) == 0 )
+            {
+                args->adaptive = true;
+            }
+            else if( strcmp( option, "recursive" ) == 0 )
+            {
+                args->recursive = true;
+            }
+            else if( strcmp( option, "list" ) == 0 )
+            {
+                args->list = true;
+            }
+            else if( strcmp( option, "stats" ) == 0 )
+            {
+                /* The format is optional (--stats or --stats=json), so the next argument is never taken */
+                args->stats = "";
+            }
+            else if( strncmp( option, "stats=", 6 ) == 0 )
+            {
+                args->stats = option + 6;
+            }
+            else if( NULL != ( value = egz_get_cli_value( option, "output", argc, argv, i ) ) )
+            {
+                args->output = value;
+            }
+            else if( NULL != ( value = egz_get_cli_value( option, "table", argc, argv, i ) ) )
+            {
+                args->table = value;
+            }
+            else if( NULL != ( value = egz_get_cli_value( option, "check", argc, argv, i ) ) )
+            {
+                args->check = value;
+            }
+            else if( NULL != ( value = egz_get_cli_value( option, "progress-fd", argc, argv, i ) ) )
+            {
+                args->progress_fd = value;
+            }
+            else if( NULL != ( value = egz_get_cli_value( option, "files-from", argc, argv, i ) ) )
+            {
+                args->files_from = value;
+            }
+            else if( NULL != ( value = egz_get_cli_value( option, "archive", argc, argv, i ) ) )
+            {
+                args->archive = value;
+            }
+            else if( NULL != ( value = egz_get_cli_value( option, "max-code-bits", argc, argv, i ) ) )
+            {
+                args->max_code_bits = ( unsigned int )strtoul( value, NULL, 10 );
+            }
+            else if( NULL != ( value = egz_get_cli_value( option, "streams", argc, argv, i ) ) )
+            {
+                args->streams = ( unsigned int )strtoul( value, NULL, 10 );
+            }
+            else if( NULL != ( value = egz_get_cli_value( option, "block-size", argc, argv, i ) ) )
+            {
+                args->block_size = ( unsigned int )strtoul( value, NULL, 10 ) * 1024;
+            }
+            else if( NULL != ( value = egz_get_cli_value( option, "threads", argc, argv, i ) ) )
+            {
+                args->threads = ( unsigned int )strtoul( value, NULL, 10 );
+            }
+            
+        default:
+            
+            break;
+    }
+}
+
+/*!
+ * 
+ */
+static char * egz_get_cli_value( char * option, char * name, int argc, char *** argv, int * i )
+{
+    size_t length;
+    
+    length = strlen( name );
+    
+    /* Not the requested argument */
+    if( strncmp( option, name, length ) != 0 )
+    {
+        return NULL;
     }
     
-    /* Checks if we still have arguments */
-    if( i++ < argc )
+    /* Value in the same argument (--name=value) */
+    if( option[ length ] == '=' )
     {
-        /* Stores the source file */
-        args->source = *( argv );
+        return option + length + 1;
     }
+    else if( option[ length ] != 0 )
+    {
+        return NULL;
+    }
+    
+    /* Value in the next argument (--name value) */
+    if( *( i ) + 1 < argc )
+    {
+        ( *( i ) )++;
+        
+        return *( ++( *( argv ) ) );
+    }
+    
+    return "";
 }
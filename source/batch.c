@@ -0,0 +1,449 @@
+/*******************************************************************************
+ * Copyright (c) 2010, Jean-David Gadina - www.xs-labs.com
+ * Distributed under the Boost Software License, Version 1.0.
+ * 
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ * 
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ * 
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ******************************************************************************/
+
+/* $Id$ */
+
+/*!
+ * @file        batch.c
+ * @copyright   (c) 2011 - Jean-David Gadina - www.xs-labs.com
+ * @abstract    Batches of small messages
+ */
+
+/* Local includes */
+#include "egz.h"
+
+/* Private functions */
+static size_t          egz_batch_put_length( unsigned char * data, uint64_t value );
+static unsigned char * egz_batch_get_length( unsigned char * data, unsigned char * end, uint64_t * value );
+static void            egz_batch_pack_words( uint64_t * words, unsigned char * data, size_t length );
+static void            egz_batch_unpack_words( unsigned char * data, size_t length, unsigned char * words );
+static egz_status      egz_batch_seek( egz_batch * batch, size_t index, uint64_t * original_length, uint64_t * payload_length, unsigned char ** payload );
+
+/*!
+ * 
+ */
+size_t egz_compress_batch_bound( egz_context * context, size_t * lengths, size_t count )
+{
+    size_t i;
+    size_t length;
+    
+    /* Header with a full table + two length prefixes and every symbol with the longest code, for each message */
+    length = EGZ_HEADER_PREFIX_LENGTH + 5 + 2 + 256;
+    
+    for( i = 0; i < count; i++ )
+    {
+        length += 2 * EGZ_BATCH_PREFIX_MAX_LENGTH + ( lengths[ i ] * context->options.max_code_bits + 7 ) / 8;
+    }
+    
+    return length;
+}
+
+/*!
+ * 
+ */
+egz_status egz_compress_batch( egz_context * context, unsigned char ** messages, size_t * lengths, size_t count, unsigned char * destination, size_t capacity, size_t * written )
+{
+    size_t          i;
+    size_t          j;
+    size_t          total;
+    size_t          payload_length;
+    uint64_t        bits;
+    uint16_t        header_length;
+    uint32_t        message_count;
+    egz_table     * table;
+    egz_symbol   ** symbols;
+    egz_symbol    * s;
+    egz_bitwriter   writer;
+    egz_histogram   histogram;
+    egz_status      status;
+    
+    *( written ) = 0;
+    
+    if( count > 0xFFFFFFFF )
+    {
+        return EGZ_ERROR_INVALID_INDEX;
+    }
+    
+    if( NULL == ( table = egz_create_table() ) )
+    {
+        return EGZ_ERROR_MALLOC;
+    }
+    
+    egz_histogram_begin( &histogram );
+    
+    /* One table for all the messages - The lanes are merged once */
+    for( i = 0; i < count; i++ )
+    {
+        egz_histogram_update( &histogram, messages[ i ], lengths[ i ] );
+    }
+    
+    egz_histogram_end( &histogram, table );
+    
+    if( table->total == 0 )
+    {
+        free( table );
+        return EGZ_ERROR_EMPTY_FILE;
+    }
+    
+    if( NULL == ( symbols = ( egz_symbol ** )malloc( sizeof( egz_symbol * ) * table->count ) ) )
+    {
+        free( table );
+        return EGZ_ERROR_MALLOC;
+    }
+    
+    if( egz_create_table_codes( table, symbols, context->options.max_code_bits ) == false )
+    {
+        free( symbols );
+        free( table );
+        return EGZ_ERROR_MALLOC;
+    }
+    
+    free( symbols );
+    
+    /* Options + number of messages + code lengths */
+    header_length = 5 + egz_get_lengths_size( table );
+    message_count = ( uint32_t )count;
+    
+    if( capacity < EGZ_HEADER_PREFIX_LENGTH + ( size_t )header_length )
+    {
+        free( table );
+        return EGZ_ERROR_BUFFER_TOO_SMALL;
+    }
+    
+    if( egz_bitwriter_init( &writer ) == false )
+    {
+        free( table );
+        return EGZ_ERROR_MALLOC;
+    }
+    
+    memcpy( destination,     EGZ_FILE_ID,       strlen( EGZ_FILE_ID ) );
+    memcpy( destination + 3, &header_length,    sizeof( uint16_t ) );
+    memcpy( destination + 5, EGZ_FILE_BATCH_ID, strlen( EGZ_FILE_BATCH_ID ) );
+    
+    destination[ EGZ_HEADER_PREFIX_LENGTH ] = 0;
+    
+    memcpy( destination + EGZ_HEADER_PREFIX_LENGTH + 1, &message_count, sizeof( uint32_t ) );
+    egz_pack_lengths( table, destination + EGZ_HEADER_PREFIX_LENGTH + 5 );
+    
+    total  = EGZ_HEADER_PREFIX_LENGTH + header_length;
+    status = EGZ_OK;
+    
+    /* Each message is a bare bitstream, after its original and compressed lengths */
+    for( i = 0; i < count; i++ )
+    {
+        egz_bitwriter_reset( &writer );
+        
+        if( egz_bitwriter_reserve( &writer, ( uint64_t )lengths[ i ] * context->options.max_code_bits ) == false )
+        {
+            status = EGZ_ERROR_MALLOC;
+            break;
+        }
+        
+        for( j = 0; j < lengths[ i ]; j++ )
+        {
+            s = &( table->symbols[ messages[ i ][ j ] ] );
+            
+            EGZ_BITWRITER_PUT( &writer, s->code, s->bits );
+        }
+        
+        bits           = ( uint64_t )writer.length * 64 + writer.bits;
+        payload_length = ( size_t )( ( bits + 7 ) / 8 );
+        
+        if( egz_bitwriter_flush( &writer ) == false )
+        {
+            status = EGZ_ERROR_MALLOC;
+            break;
+        }
+        
+        if( capacity - total < 2 * EGZ_BATCH_PREFIX_MAX_LENGTH + payload_length )
+        {
+            status = EGZ_ERROR_BUFFER_TOO_SMALL;
+            break;
+        }
+        
+        total += egz_batch_put_length( destination + total, lengths[ i ] );
+        total += egz_batch_put_length( destination + total, payload_length );
+        
+        egz_batch_pack_words( writer.words, destination + total, payload_length );
+        
+        total += payload_length;
+    }
+    
+    egz_bitwriter_free( &writer );
+    free( table );
+    
+    if( status == EGZ_OK )
+    {
+        *( written ) = total;
+    }
+    
+    return status;
+}
+
+/*!
+ * 
+ */
+egz_status egz_batch_open( egz_batch * batch, unsigned char * source, size_t length )
+{
+    uint16_t      header_length;
+    uint32_t      count;
+    unsigned char lengths[ 256 ];
+    
+    batch->lookup = NULL;
+    
+    egz_block_init( &( batch->words ) );
+    
+    if( length < EGZ_HEADER_PREFIX_LENGTH || memcmp( source, EGZ_FILE_ID, strlen( EGZ_FILE_ID ) ) != 0 || memcmp( source + 5, EGZ_FILE_BATCH_ID, strlen( EGZ_FILE_BATCH_ID ) ) != 0 )
+    {
+        return EGZ_ERROR_INVALID_FORMAT;
+    }
+    
+    memcpy( &header_length, source + 3, sizeof( uint16_t ) );
+    
+    /* Smallest header: options + number of messages + number of symbols */
+    if( header_length < 5 + 2 || length < EGZ_HEADER_PREFIX_LENGTH + ( size_t )header_length || source[ EGZ_HEADER_PREFIX_LENGTH ] != 0 )
+    {
+        return EGZ_ERROR_INVALID_FORMAT;
+    }
+    
+    memcpy( &count, source + EGZ_HEADER_PREFIX_LENGTH + 1, sizeof( uint32_t ) );
+    
+    if( egz_rebuild_lengths( source + EGZ_HEADER_PREFIX_LENGTH + 5, lengths, header_length - 5 ) == 0 )
+    {
+        return EGZ_ERROR_INVALID_FORMAT;
+    }
+    
+    batch->data     = source + EGZ_HEADER_PREFIX_LENGTH + header_length;
+    batch->end      = source + length;
+    batch->count    = count;
+    batch->index    = 0;
+    batch->position = batch->data;
+    
+    /* The lookup table is built once, for all the messages */
+    return egz_create_canonical_lookup( &( batch->lookup ), lengths );
+}
+
+/*!
+ * 
+ */
+void egz_batch_close( egz_batch * batch )
+{
+    free( batch->lookup );
+    egz_block_free( &( batch->words ) );
+    
+    batch->lookup = NULL;
+}
+
+/*!
+ * 
+ */
+egz_status egz_batch_length( egz_batch * batch, size_t index, size_t * length )
+{
+    uint64_t        original_length;
+    uint64_t        payload_length;
+    unsigned char * payload;
+    egz_status      status;
+    
+    if( EGZ_OK != ( status = egz_batch_seek( batch, index, &original_length, &payload_length, &payload ) ) )
+    {
+        return status;
+    }
+    
+    *( length ) = ( size_t )original_length;
+    
+    return EGZ_OK;
+}
+
+/*!
+ * 
+ */
+egz_status egz_batch_expand( egz_batch * batch, size_t index, unsigned char * destination, size_t capacity, size_t * written )
+{
+    size_t          words;
+    uint64_t        original_length;
+    uint64_t        payload_length;
+    unsigned char * payload;
+    egz_bitreader   reader;
+    egz_status      status;
+    
+    *( written ) = 0;
+    
+    if( EGZ_OK != ( status = egz_batch_seek( batch, index, &original_length, &payload_length, &payload ) ) )
+    {
+        return status;
+    }
+    
+    if( original_length > capacity )
+    {
+        return EGZ_ERROR_BUFFER_TOO_SMALL;
+    }
+    
+    words = ( size_t )( ( payload_length + 7 ) / 8 );
+    
+    if( egz_block_reserve( &( batch->words ), words * sizeof( uint64_t ) ) == false )
+    {
+        return EGZ_ERROR_MALLOC;
+    }
+    
+    egz_batch_unpack_words( payload, ( size_t )payload_length, batch->words.data );
+    egz_bitreader_init_memory( &reader, batch->words.data, words );
+    
+    if( EGZ_OK != ( status = egz_decode_streams( &reader, 1, batch->lookup, destination, ( size_t )original_length ) ) )
+    {
+        return status;
+    }
+    
+    *( written ) = ( size_t )original_length;
+    
+    return EGZ_OK;
+}
+
+/*!
+ * 
+ */
+static egz_status egz_batch_seek( egz_batch * batch, size_t index, uint64_t * original_length, uint64_t * payload_length, unsigned char ** payload )
+{
+    unsigned char * p;
+    
+    if( index >= batch->count )
+    {
+        return EGZ_ERROR_INVALID_INDEX;
+    }
+    
+    /* Messages are reached through the lengths of the previous ones, so only go back when needed */
+    if( index < batch->index )
+    {
+        batch->index    = 0;
+        batch->position = batch->data;
+    }
+    
+    while( true )
+    {
+        if( NULL == ( p = egz_batch_get_length( batch->position, batch->end, original_length ) ) || NULL == ( p = egz_batch_get_length( p, batch->end, payload_length ) ) )
+        {
+            return EGZ_ERROR_INVALID_FORMAT;
+        }
+        
+        /* Every code has between 1 and the maximum number of bits */
+        if( *( payload_length ) > ( uint64_t )( batch->end - p ) || *( original_length ) > *( payload_length ) * 8 || *( payload_length ) > ( *( original_length ) * EGZ_BTREE_CODE_MAX_LENGTH + 7 ) / 8 )
+        {
+            return EGZ_ERROR_INVALID_FORMAT;
+        }
+        
+        if( batch->index == index )
+        {
+            *( payload ) = p;
+            
+            return EGZ_OK;
+        }
+        
+        batch->position = p + *( payload_length );
+        batch->index++;
+    }
+}
+
+/*!
+ * 
+ */
+static size_t egz_batch_put_length( unsigned char * data, uint64_t value )
+{
+    size_t length;
+    
+    length = 0;
+    
+    /* 7 bits per byte, with the high bit set when more bytes follow */
+    while( value >= 0x80 )
+    {
+        data[ length++ ] = ( unsigned char )( value | 0x80 );
+        value          >>= 7;
+    }
+    
+    data[ length++ ] = ( unsigned char )value;
+    
+    return length;
+}
+
+/*!
+ * 
+ */
+static unsigned char * egz_batch_get_length( unsigned char * data, unsigned char * end, uint64_t * value )
+{
+    unsigned int shift;
+    
+    *( value ) = 0;
+    
+    for( shift = 0; shift < EGZ_BATCH_PREFIX_MAX_LENGTH * 7 && data < end; shift += 7 )
+    {
+        *( value ) |= ( uint64_t )( *( data ) & 0x7F ) << shift;
+        
+        if( ( *( data++ ) & 0x80 ) == 0 )
+        {
+            return data;
+        }
+    }
+    
+    return NULL;
+}
+
+/*!
+ * 
+ */
+static void egz_batch_pack_words( uint64_t * words, unsigned char * data, size_t length )
+{
+    size_t i;
+    
+    /* Most significant byte first, as the codes are written from the top of each word */
+    for( i = 0; i < length; i++ )
+    {
+        data[ i ] = ( unsigned char )( words[ i / 8 ] >> ( 56 - ( i % 8 ) * 8 ) );
+    }
+}
+
+/*!
+ * 
+ */
+static void egz_batch_unpack_words( unsigned char * data, size_t length, unsigned char * words )
+{
+    size_t   i;
+    size_t   j;
+    uint64_t word;
+    
+    /* The last word is padded with zeros */
+    for( i = 0; i < length; i += 8 )
+    {
+        word = 0;
+        
+        for( j = 0; j < 8; j++ )
+        {
+            word = ( word << 8 ) | ( ( i + j < length ) ? data[ i + j ] : 0 );
+        }
+        
+        memcpy( words + i, &word, sizeof( uint64_t ) );
+    }
+}
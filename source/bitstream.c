@@ -0,0 +1,205 @@
+/*******************************************************************************
+ * Copyright (c) 2010, Jean-David Gadina - www.xs-labs.com
+ * Distributed under the Boost Software License, Version 1.0.
+ * 
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ * 
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ * 
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ******************************************************************************/
+
+/* $Id$ */
+
+/*!
+ * @file        bitstream.c
+ * @copyright   (c) 2011 - Jean-David Gadina - www.xs-labs.com
+ * @abstract    Bitstream functions
+ */
+
+/* Local includes */
+#include "egz.h"
+
+/*!
+ * 
+ */
+void egz_bitreader_init( egz_bitreader * reader, FILE * source )
+{
+    reader->source   = source;
+    reader->data     = ( unsigned char * )( reader->buffer );
+    reader->length   = 0;
+    reader->index    = 0;
+    reader->position = 0;
+    
+    /* The reader always keeps two words, so 64 bits can be peeked at any position */
+    reader->current  = egz_bitreader_load( reader );
+    reader->next     = egz_bitreader_load( reader );
+}
+
+/*!
+ * 
+ */
+void egz_bitreader_init_memory( egz_bitreader * reader, unsigned char * data, size_t length )
+{
+    reader->source   = NULL;
+    reader->data     = data;
+    reader->length   = length;
+    reader->index    = 0;
+    reader->position = 0;
+    reader->current  = egz_bitreader_load( reader );
+    reader->next     = egz_bitreader_load( reader );
+}
+
+/*!
+ * 
+ */
+uint64_t egz_bitreader_load( egz_bitreader * reader )
+{
+    uint64_t word;
+    
+    /* Refills the buffer from the source file */
+    if( reader->index == reader->length )
+    {
+        /* End of the data - Pads with zeros */
+        if( reader->source == NULL )
+        {
+            return 0;
+        }
+        
+        reader->index  = 0;
+        reader->length = fread( reader->buffer, sizeof( uint64_t ), EGZ_READ_BUFFER_LENGTH, reader->source );
+        
+        if( reader->length == 0 )
+        {
+            return 0;
+        }
+    }
+    
+    /* Memory data may not be aligned on a word boundary */
+    memcpy( &word, reader->data + reader->index * sizeof( uint64_t ), sizeof( uint64_t ) );
+    
+    reader->index++;
+    
+    return word;
+}
+
+/*!
+ * 
+ */
+bool egz_bitwriter_init( egz_bitwriter * writer )
+{
+    writer->length   = 0;
+    writer->capacity = EGZ_WRITE_BUFFER_LENGTH;
+    writer->current  = 0;
+    writer->bits     = 0;
+    
+    if( NULL == ( writer->words = ( uint64_t * )malloc( sizeof( uint64_t ) * writer->capacity ) ) )
+    {
+        return false;
+    }
+    
+    return true;
+}
+
+/*!
+ * 
+ */
+void egz_bitwriter_reset( egz_bitwriter * writer )
+{
+    /* The words are kept for the next data */
+    writer->length  = 0;
+    writer->current = 0;
+    writer->bits    = 0;
+}
+
+/*!
+ * 
+ */
+bool egz_bitwriter_reserve( egz_bitwriter * writer, uint64_t bits )
+{
+    size_t     capacity;
+    uint64_t * words;
+    
+    /* Room for the written words, the new bits and the word being filled */
+    capacity = writer->length + ( size_t )( ( writer->bits + bits ) / 64 ) + 1;
+    
+    if( capacity <= writer->capacity )
+    {
+        return true;
+    }
+    
+    capacity = ( capacity > writer->capacity * 2 ) ? capacity : writer->capacity * 2;
+    
+    if( NULL == ( words = ( uint64_t * )realloc( writer->words, sizeof( uint64_t ) * capacity ) ) )
+    {
+        return false;
+    }
+    
+    writer->words    = words;
+    writer->capacity = capacity;
+    
+    return true;
+}
+
+/*!
+ * 
+ */
+bool egz_bitwriter_put( egz_bitwriter * writer, uint64_t code, unsigned int bits )
+{
+    if( egz_bitwriter_reserve( writer, bits ) == false )
+    {
+        return false;
+    }
+    
+    EGZ_BITWRITER_PUT( writer, code, bits );
+    
+    return true;
+}
+
+/*!
+ * 
+ */
+bool egz_bitwriter_flush( egz_bitwriter * writer )
+{
+    unsigned int bits;
+    
+    /* Pads the last word with zeros */
+    if( writer->bits > 0 )
+    {
+        bits = 64 - writer->bits;
+        
+        return egz_bitwriter_put( writer, 0, bits );
+    }
+    
+    return true;
+}
+
+/*!
+ * 
+ */
+void egz_bitwriter_free( egz_bitwriter * writer )
+{
+    free( writer->words );
+    
+    writer->words    = NULL;
+    writer->length   = 0;
+    writer->capacity = 0;
+}
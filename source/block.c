@@ -0,0 +1,682 @@
+/*******************************************************************************
+ * Copyright (c) 2010, Jean-David Gadina - www.xs-labs.com
+ * Distributed under the Boost Software License, Version 1.0.
+ * 
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ * 
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ * 
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ******************************************************************************/
+
+/* $Id$ */
+
+/*!
+ * @file        block.c
+ * @copyright   (c) 2011 - Jean-David Gadina - www.xs-labs.com
+ * @abstract    Block functions
+ */
+
+/* Local includes */
+#include "egz.h"
+
+/* Private functions */
+static egz_status egz_store_block( unsigned char * data, size_t length, uint8_t flags, uint32_t checksum, egz_block * block );
+static egz_status egz_decode_block( unsigned char * data, size_t length, egz_block_header * header, egz_lookup * shared, unsigned char * output );
+static double     egz_split_cost( unsigned long * histogram );
+
+/*!
+ * 
+ */
+void egz_block_init( egz_block * block )
+{
+    block->data     = NULL;
+    block->length   = 0;
+    block->capacity = 0;
+}
+
+/*!
+ * 
+ */
+bool egz_block_reserve( egz_block * block, size_t length )
+{
+    unsigned char * data;
+    
+    if( length <= block->capacity )
+    {
+        return true;
+    }
+    
+    if( NULL == ( data = ( unsigned char * )realloc( block->data, length ) ) )
+    {
+        return false;
+    }
+    
+    block->data     = data;
+    block->capacity = length;
+    
+    return true;
+}
+
+/*!
+ * 
+ */
+void egz_block_free( egz_block * block )
+{
+    free( block->data );
+    egz_block_init( block );
+}
+
+/*!
+ * 
+ */
+egz_status egz_compress_block( unsigned char * data, size_t length, egz_table * shared, egz_options * options, egz_block * block )
+{
+    unsigned int    i;
+    unsigned int    stream;
+    unsigned int    streams;
+    unsigned int    max_bits;
+    uint8_t         flags;
+    uint8_t         stored;
+    uint32_t        original_length;
+    uint32_t        payload_length;
+    uint32_t        checksum;
+    uint32_t        lengths[ EGZ_STREAMS_MAX ];
+    uint64_t        bits_own;
+    uint64_t        bits_shared;
+    size_t          j;
+    size_t          table_length;
+    unsigned char * p;
+    egz_table     * table;
+    egz_table     * codes;
+    egz_symbol    * s;
+    egz_symbol    * symbols[ 256 ];
+    egz_bitwriter   writers[ EGZ_STREAMS_MAX ];
+    egz_status      status;
+    
+    if( NULL == ( table = egz_create_table() ) )
+    {
+        return EGZ_ERROR_MALLOC;
+    }
+    
+    /* Per-block checksum of the original data, unless the file has no checksum at all */
+    checksum = ( options->checksum_type != EGZ_CHECKSUM_NONE ) ? egz_crc32c( 0xFFFFFFFF, data, length ) ^ 0xFFFFFFFF : 0;
+    stored   = ( options->checksum_type != EGZ_CHECKSUM_NONE ) ? EGZ_BLOCK_FLAG_STORED | EGZ_BLOCK_FLAG_CHECKSUM : EGZ_BLOCK_FLAG_STORED;
+    
+    egz_count_symbols( table, data, length );
+    
+    if( egz_create_table_codes( table, symbols, options->max_code_bits ) == false )
+    {
+        free( table );
+        return EGZ_ERROR_MALLOC;
+    }
+    
+    bits_own    = 0;
+    bits_shared = 0;
+    
+    /* Cost of the block with its own codes and with the shared ones */
+    for( i = 0; i < 256; i++ )
+    {
+        if( table->symbols[ i ].occurences == 0 )
+        {
+            continue;
+        }
+        
+        bits_own += ( uint64_t )table->symbols[ i ].occurences * table->symbols[ i ].bits;
+        
+        /* The shared table cannot encode the symbol */
+        if( shared == NULL || shared->symbols[ i ].bits == 0 )
+        {
+            bits_shared = ( uint64_t )-1;
+        }
+        else if( bits_shared != ( uint64_t )-1 )
+        {
+            bits_shared += ( uint64_t )table->symbols[ i ].occurences * shared->symbols[ i ].bits;
+        }
+    }
+    
+    table_length = egz_get_lengths_size( table );
+    
+    /* The block gets its own table only if it saves more than it costs */
+    if( bits_shared == ( uint64_t )-1 || bits_own + table_length * 8 < bits_shared )
+    {
+        flags = EGZ_BLOCK_FLAG_TABLE;
+        codes = table;
+    }
+    else
+    {
+        flags        = 0;
+        codes        = shared;
+        table_length = 0;
+    }
+    
+    EGZ_TRACE_BLOCK( EGZ_TRACE_BLOCK_CODES, length, flags, ( flags != 0 ) ? bits_own + table_length * 8 : bits_shared );
+    
+    /* Incompressible data - The block is copied as it is, without encoding it */
+    if( ( ( ( flags & EGZ_BLOCK_FLAG_TABLE ) != 0 ) ? bits_own + table_length * 8 : bits_shared ) / 8 >= length )
+    {
+        free( table );
+        
+        return egz_store_block( data, length, stored, checksum, block );
+    }
+    
+    /* Small blocks are not worth the stream table */
+    streams  = ( length < EGZ_STREAMS_MIN_SIZE ) ? 1 : options->streams;
+    stream   = 0;
+    status   = EGZ_OK;
+    max_bits = 0;
+    
+    for( i = 0; i < 256; i++ )
+    {
+        if( table->symbols[ i ].occurences > 0 && codes->symbols[ i ].bits > max_bits )
+        {
+            max_bits = codes->symbols[ i ].bits;
+        }
+    }
+    
+    /* Each stream gets room for all its symbols with the longest code, so the writes need no check */
+    for( i = 0; i < streams; i++ )
+    {
+        if( egz_bitwriter_init( &( writers[ i ] ) ) == false || egz_bitwriter_reserve( &( writers[ i ] ), ( uint64_t )( ( length + streams - 1 ) / streams ) * max_bits ) == false )
+        {
+            egz_bitwriter_free( &( writers[ i ] ) );
+            
+            while( i-- > 0 )
+            {
+                egz_bitwriter_free( &( writers[ i ] ) );
+            }
+            
+            free( table );
+            
+            return EGZ_ERROR_MALLOC;
+        }
+    }
+    
+    /* Symbols are spread round-robin over the streams, so they can be decoded in parallel */
+    for( j = 0; j < length; j++ )
+    {
+        s = &( codes->symbols[ data[ j ] ] );
+        
+        EGZ_BITWRITER_PUT( &( writers[ stream ] ), s->code, s->bits );
+        
+        stream = ( stream + 1 == streams ) ? 0 : stream + 1;
+    }
+    
+    payload_length = ( uint32_t )table_length + ( ( streams > 1 ) ? streams * sizeof( uint32_t ) : 0 );
+    
+    for( i = 0; i < streams; i++ )
+    {
+        if( status == EGZ_OK && egz_bitwriter_flush( &( writers[ i ] ) ) == false )
+        {
+            status = EGZ_ERROR_MALLOC;
+        }
+        
+        lengths[ i ]    = ( uint32_t )writers[ i ].length;
+        payload_length += lengths[ i ] * sizeof( uint64_t );
+    }
+    
+    /* The stream table and padding made the block larger than the data */
+    if( status == EGZ_OK && payload_length >= length )
+    {
+        for( i = 0; i < streams; i++ )
+        {
+            egz_bitwriter_free( &( writers[ i ] ) );
+        }
+        
+        free( table );
+        
+        return egz_store_block( data, length, stored, checksum, block );
+    }
+    
+    /* The checksum comes first in the payload */
+    if( options->checksum_type != EGZ_CHECKSUM_NONE )
+    {
+        flags          |= EGZ_BLOCK_FLAG_CHECKSUM;
+        payload_length += sizeof( uint32_t );
+    }
+    
+    if( status == EGZ_OK && egz_block_reserve( block, EGZ_BLOCK_HEADER_LENGTH + payload_length ) == false )
+    {
+        status = EGZ_ERROR_MALLOC;
+    }
+    
+    if( status == EGZ_OK )
+    {
+        p               = block->data;
+        original_length = ( uint32_t )length;
+        
+        /* Block header - Options, number of streams, original and compressed lengths */
+        p[ 0 ] = flags;
+        p[ 1 ] = ( uint8_t )streams;
+        
+        memcpy( p + 2, &original_length, sizeof( uint32_t ) );
+        memcpy( p + 6, &payload_length,  sizeof( uint32_t ) );
+        
+        p += EGZ_BLOCK_HEADER_LENGTH;
+        
+        if( ( flags & EGZ_BLOCK_FLAG_CHECKSUM ) != 0 )
+        {
+            memcpy( p, &checksum, sizeof( uint32_t ) );
+            
+            p += sizeof( uint32_t );
+        }
+        
+        if( ( flags & EGZ_BLOCK_FLAG_TABLE ) != 0 )
+        {
+            egz_pack_lengths( table, p );
+            
+            p += table_length;
+        }
+        
+        /* Jump table - Length of each stream, in words */
+        if( streams > 1 )
+        {
+            memcpy( p, lengths, streams * sizeof( uint32_t ) );
+            
+            p += streams * sizeof( uint32_t );
+        }
+        
+        for( i = 0; i < streams; i++ )
+        {
+            memcpy( p, writers[ i ].words, lengths[ i ] * sizeof( uint64_t ) );
+            
+            p += lengths[ i ] * sizeof( uint64_t );
+        }
+        
+        block->length = EGZ_BLOCK_HEADER_LENGTH + payload_length;
+    }
+    
+    for( i = 0; i < streams; i++ )
+    {
+        egz_bitwriter_free( &( writers[ i ] ) );
+    }
+    
+    free( table );
+    
+    return status;
+}
+
+/*!
+ * 
+ */
+egz_status egz_read_block_header( unsigned char * data, egz_block_header * header )
+{
+    header->flags   = data[ 0 ];
+    header->streams = data[ 1 ];
+    
+    memcpy( &( header->original_length ), data + 2, sizeof( uint32_t ) );
+    memcpy( &( header->payload_length ),  data + 6, sizeof( uint32_t ) );
+    
+    if( ( header->flags & ~( EGZ_BLOCK_FLAG_TABLE | EGZ_BLOCK_FLAG_STORED | EGZ_BLOCK_FLAG_CHECKSUM ) ) != 0 || header->streams < 1 || header->streams > EGZ_STREAMS_MAX )
+    {
+        return EGZ_ERROR_INVALID_FORMAT;
+    }
+    
+    /* Stored blocks have no table, and their data as it is (after the checksum) */
+    if( ( header->flags & EGZ_BLOCK_FLAG_STORED ) != 0 && ( ( header->flags & EGZ_BLOCK_FLAG_TABLE ) != 0 || ( uint64_t )header->payload_length != ( uint64_t )header->original_length + ( ( ( header->flags & EGZ_BLOCK_FLAG_CHECKSUM ) != 0 ) ? sizeof( uint32_t ) : 0 ) ) )
+    {
+        return EGZ_ERROR_INVALID_FORMAT;
+    }
+    
+    if( ( header->flags & EGZ_BLOCK_FLAG_CHECKSUM ) != 0 && header->payload_length < sizeof( uint32_t ) )
+    {
+        return EGZ_ERROR_INVALID_FORMAT;
+    }
+    
+    if( header->original_length > EGZ_BLOCK_SIZE_MAX || header->payload_length > egz_block_bound( EGZ_BLOCK_SIZE_MAX ) )
+    {
+        return EGZ_ERROR_INVALID_FORMAT;
+    }
+    
+    return EGZ_OK;
+}
+
+/*!
+ * 
+ */
+bool egz_block_is_end( unsigned char * data )
+{
+    unsigned int i;
+    
+    /* Streamed files end with an empty block header */
+    for( i = 0; i < EGZ_BLOCK_HEADER_LENGTH; i++ )
+    {
+        if( data[ i ] != 0 )
+        {
+            return false;
+        }
+    }
+    
+    return true;
+}
+
+/*!
+ * 
+ */
+size_t egz_block_bound( size_t length )
+{
+    /* Checksum + table + jump table + every symbol with the longest code, padded to a word in each stream */
+    return sizeof( uint32_t ) + 2 + 256 + EGZ_STREAMS_MAX * ( sizeof( uint32_t ) + sizeof( uint64_t ) ) + length * sizeof( uint64_t );
+}
+
+/*!
+ * 
+ */
+size_t egz_split_block( unsigned char * data, size_t length, size_t max_length )
+{
+    unsigned int  i;
+    size_t        offset;
+    size_t        part;
+    unsigned int  count;
+    double        cost_block;
+    double        cost_segment;
+    double        cost_merged;
+    double        cost_split;
+    unsigned long block[ 256 ];
+    unsigned long segment[ 256 ];
+    unsigned long merged[ 256 ];
+    
+    length = ( length < max_length ) ? length : max_length;
+    offset = ( length < EGZ_SPLIT_SEGMENT_LENGTH ) ? length : EGZ_SPLIT_SEGMENT_LENGTH;
+    
+    memset( block, 0, sizeof( block ) );
+    egz_count_histogram( block, data, offset );
+    
+    cost_block = egz_split_cost( block );
+    
+    /* The block grows one segment at a time, until the next segment is cheaper on its own */
+    while( offset < length )
+    {
+        part  = ( length - offset < EGZ_SPLIT_SEGMENT_LENGTH ) ? length - offset : EGZ_SPLIT_SEGMENT_LENGTH;
+        count = 0;
+        
+        memset( segment, 0, sizeof( segment ) );
+        egz_count_histogram( segment, data + offset, part );
+        
+        for( i = 0; i < 256; i++ )
+        {
+            merged[ i ] = block[ i ] + segment[ i ];
+            count      += ( segment[ i ] > 0 ) ? 1 : 0;
+        }
+        
+        cost_segment = egz_split_cost( segment );
+        cost_merged  = egz_split_cost( merged );
+        
+        /* A new block costs its header and its own table */
+        cost_split = cost_block + cost_segment + ( EGZ_BLOCK_HEADER_LENGTH + ( ( count > EGZ_HEADER_LENGTHS_PAIRS ) ? 2 + 256 : 2 + count * 2 ) ) * 8;
+        
+        if( cost_split < cost_merged )
+        {
+            break;
+        }
+        
+        memcpy( block, merged, sizeof( block ) );
+        
+        cost_block = cost_merged;
+        offset    += part;
+    }
+    
+    return offset;
+}
+
+/*!
+ * 
+ */
+egz_status egz_expand_block( unsigned char * data, egz_block_header * header, egz_lookup * shared, unsigned char * output )
+{
+    uint32_t   checksum;
+    size_t     length;
+    egz_status status;
+    
+    checksum = 0;
+    length   = header->payload_length;
+    
+    if( ( header->flags & EGZ_BLOCK_FLAG_CHECKSUM ) != 0 )
+    {
+        memcpy( &checksum, data, sizeof( uint32_t ) );
+        
+        data   += sizeof( uint32_t );
+        length -= sizeof( uint32_t );
+    }
+    
+    /* Stored block - The data is copied as it is */
+    if( ( header->flags & EGZ_BLOCK_FLAG_STORED ) != 0 )
+    {
+        memcpy( output, data, header->original_length );
+        
+        status = EGZ_OK;
+    }
+    else
+    {
+        status = egz_decode_block( data, length, header, shared, output );
+    }
+    
+    /* The block is checked as soon as it is decoded, so corrupted data is reported where it is */
+    if( status == EGZ_OK && ( header->flags & EGZ_BLOCK_FLAG_CHECKSUM ) != 0 && ( egz_crc32c( 0xFFFFFFFF, output, header->original_length ) ^ 0xFFFFFFFF ) != checksum )
+    {
+        status = EGZ_ERROR_INVALID_CHECKSUM;
+    }
+    
+    return status;
+}
+
+/*!
+ * 
+ */
+egz_status egz_decode_streams( egz_bitreader * readers, unsigned int streams, egz_lookup * lookup, unsigned char * output, size_t length )
+{
+    unsigned int   i;
+    unsigned int   bits;
+    unsigned int   round;
+    size_t         j;
+    uint64_t       window;
+    
+    /* Symbols are spread round-robin - One symbol from each stream per round, with independent readers */
+    for( j = 0; j < length; j += round )
+    {
+        round = ( length - j < streams ) ? ( unsigned int )( length - j ) : streams;
+        
+        for( i = 0; i < round; i++ )
+        {
+            window = EGZ_BITREADER_PEEK( &( readers[ i ] ) );
+            
+            EGZ_LOOKUP_DECODE( lookup, window, output[ j + i ], bits );
+            
+            if( bits == 0 )
+            {
+                return EGZ_ERROR_INVALID_TREE;
+            }
+            
+            EGZ_BITREADER_SKIP( &( readers[ i ] ), bits );
+        }
+    }
+    
+    return EGZ_OK;
+}
+
+/*!
+ * 
+ */
+static egz_status egz_store_block( unsigned char * data, size_t length, uint8_t flags, uint32_t checksum, egz_block * block )
+{
+    uint32_t        original_length;
+    uint32_t        payload_length;
+    unsigned char * p;
+    
+    original_length = ( uint32_t )length;
+    payload_length  = ( uint32_t )length + ( ( ( flags & EGZ_BLOCK_FLAG_CHECKSUM ) != 0 ) ? sizeof( uint32_t ) : 0 );
+    
+    EGZ_TRACE_BLOCK( EGZ_TRACE_BLOCK_STORED, original_length, payload_length, flags );
+    
+    if( egz_block_reserve( block, EGZ_BLOCK_HEADER_LENGTH + payload_length ) == false )
+    {
+        return EGZ_ERROR_MALLOC;
+    }
+    
+    p = block->data;
+    
+    /* Block header - The compressed length is the original one, with the checksum */
+    p[ 0 ] = flags;
+    p[ 1 ] = 1;
+    
+    memcpy( p + 2, &original_length, sizeof( uint32_t ) );
+    memcpy( p + 6, &payload_length,  sizeof( uint32_t ) );
+    
+    p += EGZ_BLOCK_HEADER_LENGTH;
+    
+    if( ( flags & EGZ_BLOCK_FLAG_CHECKSUM ) != 0 )
+    {
+        memcpy( p, &checksum, sizeof( uint32_t ) );
+        
+        p += sizeof( uint32_t );
+    }
+    
+    memcpy( p, data, length );
+    
+    block->length = EGZ_BLOCK_HEADER_LENGTH + payload_length;
+    
+    return EGZ_OK;
+}
+
+/*!
+ * 
+ */
+static egz_status egz_decode_block( unsigned char * data, size_t length, egz_block_header * header, egz_lookup * shared, unsigned char * output )
+{
+    unsigned int    i;
+    unsigned int    count;
+    uint32_t        lengths[ EGZ_STREAMS_MAX ];
+    size_t          words;
+    unsigned char   code_lengths[ 256 ];
+    egz_lookup    * lookup;
+    egz_status      status;
+    egz_bitreader   readers[ EGZ_STREAMS_MAX ];
+    
+    lookup = shared;
+
+    /* Block with its own table */
+    if( ( header->flags & EGZ_BLOCK_FLAG_TABLE ) != 0 )
+    {
+        /* Truncated block - Not even the number of symbols */
+        if( length < 2 )
+        {
+            return EGZ_ERROR_INVALID_FORMAT;
+        }
+        
+        count = egz_rebuild_lengths( data, code_lengths, ( uint16_t )( ( length < 2 + 256 ) ? length : 2 + 256 ) );
+        
+        if( count == 0 )
+        {
+            return EGZ_ERROR_INVALID_FORMAT;
+        }
+        
+        status = egz_create_canonical_lookup( &lookup, code_lengths );
+        
+        if( status != EGZ_OK )
+        {
+            return status;
+        }
+        
+        count   = ( count > EGZ_HEADER_LENGTHS_PAIRS ) ? 2 + 256 : 2 + count * 2;
+        data   += count;
+        length -= count;
+    }
+    else if( lookup == NULL )
+    {
+        return EGZ_ERROR_INVALID_FORMAT;
+    }
+    
+    status = EGZ_OK;
+    
+    /* Jump table - Length of each stream, in words */
+    if( header->streams > 1 )
+    {
+        if( length < header->streams * sizeof( uint32_t ) )
+        {
+            status = EGZ_ERROR_INVALID_FORMAT;
+        }
+        else
+        {
+            memcpy( lengths, data, header->streams * sizeof( uint32_t ) );
+            
+            data   += header->streams * sizeof( uint32_t );
+            length -= header->streams * sizeof( uint32_t );
+        }
+    }
+    else
+    {
+        lengths[ 0 ] = ( uint32_t )( length / sizeof( uint64_t ) );
+    }
+    
+    for( i = 0, words = 0; status == EGZ_OK && i < header->streams; i++ )
+    {
+        if( lengths[ i ] > ( length / sizeof( uint64_t ) ) - words )
+        {
+            status = EGZ_ERROR_INVALID_FORMAT;
+            break;
+        }
+        
+        egz_bitreader_init_memory( &( readers[ i ] ), data + words * sizeof( uint64_t ), lengths[ i ] );
+        
+        words += lengths[ i ];
+    }
+    
+    if( status == EGZ_OK )
+    {
+        status = egz_decode_streams( readers, header->streams, lookup, output, header->original_length );
+    }
+    
+    if( lookup != shared )
+    {
+        free( lookup );
+    }
+    
+    return status;
+}
+
+/*!
+ * 
+ */
+static double egz_split_cost( unsigned long * histogram )
+{
+    unsigned int  i;
+    unsigned long total;
+    double        information;
+    
+    total       = 0;
+    information = 0;
+    
+    for( i = 0; i < 256; i++ )
+    {
+        total += histogram[ i ];
+    }
+    
+    /* Information content of the data, in bits - The size of an ideal code built for it, as computed by egz_get_symbols */
+    for( i = 0; i < 256; i++ )
+    {
+        if( histogram[ i ] > 0 )
+        {
+            information += -LOG2( ( double )histogram[ i ] / ( double )total ) * histogram[ i ];
+        }
+    }
+    
+    return information;
+}
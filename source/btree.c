@@ -42,295 +42,211 @@
 /*!
  * 
  */
-egz_symbol * egz_create_btree( egz_symbol ** symbols, unsigned int count )
+bool egz_create_table_codes( egz_table * table, egz_symbol ** symbols, unsigned int max_bits )
 {
-    unsigned int  i;
-    unsigned int  j;
-    unsigned int  k;
-    bool          found;
-    egz_symbol *  tree;
-    egz_symbol *  s1;
-    egz_symbol *  s2;
-    egz_symbol *  s3;
-    egz_symbol *  node;
-    egz_symbol ** nodes;
+    unsigned int i;
+    unsigned int j;
+    egz_timer    timer;
     
-    /* Allocates memory for the internal nodes */
-    if( NULL == ( tree = ( egz_symbol * )malloc( sizeof( egz_symbol ) * ( count - 1 ) ) ) )
+    j = 0;
+    
+    egz_stats_begin( &timer );
+    
+    /* Stores a pointer to each symbol present in the table */
+    for( i = 0; i < 256; i++ )
     {
-        return NULL;
+        if( table->symbols[ i ].occurences > 0 )
+        {
+            symbols[ j++ ] = &( table->symbols[ i ] );
+        }
     }
     
-    /* No need for the full process if there's only two symbols  */
-    if( count == 2 )
+    if( j == 0 )
     {
-        s1               = *( symbols++ );
-        s2               = *( symbols );
-        tree->character  = 0;
-        tree->occurences = s1->occurences + s2->occurences;
-        tree->entropy    = 0;
-        tree->id         = 1;
-        tree->parent     = NULL;
-        tree->left       = s2;
-        tree->right      = s1;
-        s1->parent       = tree;
-        s2->parent       = tree;
-        
-        return tree;
+        egz_stats_end( &timer, EGZ_STATS_TREE, 0, 0 );
+        return true;
+    }
+    
+    /* Sorts the symbols by their frequency */
+    egz_sort_symbols_by_occurences( symbols, 0, j - 1 );
+    
+    if( j > 1 )
+    {
+        /* Package-merge - Optimal lengths under the length limit */
+        if( egz_create_limited_lengths( symbols, j, max_bits ) == false )
+        {
+            egz_stats_end( &timer, EGZ_STATS_TREE, 0, 0 );
+            return false;
+        }
+    }
+    else
+    {
+        /* A single symbol still needs one bit per occurence */
+        ( *( symbols ) )->bits = 1;
+    }
+    
+    egz_stats_end( &timer, EGZ_STATS_TREE, 0, 0 );
+    egz_stats_begin( &timer );
+    
+    /* Only the code lengths are kept - Codes are reassigned in canonical order */
+    egz_create_canonical_codes( table );
+    
+    egz_stats_end( &timer, EGZ_STATS_CODES, 0, 0 );
+    
+    return true;
+}
+
+/*!
+ * 
+ */
+bool egz_create_limited_lengths( egz_symbol ** symbols, unsigned int count, unsigned int max_bits )
+{
+    unsigned int    i;
+    unsigned int    j;
+    unsigned int    level;
+    unsigned int    leaves;
+    unsigned int    packages;
+    unsigned int    selected;
+    unsigned int    lengths[ EGZ_BTREE_CODE_MAX_LENGTH ];
+    uint64_t        package;
+    uint64_t      * weights;
+    uint64_t      * items;
+    uint64_t      * previous;
+    unsigned char * kinds;
+    
+    /* Package-merge needs room for every symbol at the deepest level */
+    while( max_bits < EGZ_BTREE_CODE_MAX_LENGTH && ( ( uint64_t )1 << max_bits ) < count )
+    {
+        max_bits++;
     }
     
-    /* Allocates memory to store pointers to the internal nodes */
-    if( NULL == ( nodes = ( egz_symbol ** )malloc( sizeof( egz_symbol * ) * ( count - 1 ) ) ) )
+    /* Each level holds the symbols and the packages of the level below */
+    if( NULL == ( weights = ( uint64_t * )malloc( sizeof( uint64_t ) * max_bits * count * 2 ) ) )
     {
-        free( tree );
-        return NULL;
+        return false;
     }
     
-    /* Moves the pointer to the last internal node */
-    tree += count - 1;
+    if( NULL == ( kinds = ( unsigned char * )malloc( sizeof( unsigned char ) * max_bits * count * 2 ) ) )
+    {
+        free( weights );
+        return false;
+    }
     
-    /* Process each internal node */
-    for( i = 0; i < count - 1; i++ )
+    /* Deepest level - Symbols only (they are ordered by their frequency) */
+    level = max_bits - 1;
+    items = weights + level * count * 2;
+    
+    for( i = 0; i < count; i++ )
     {
-        /* Data initialization */
-        tree->character  = 0;
-        tree->occurences = 0;
-        tree->entropy    = 0;
-        tree->id         = 0;
-        tree->parent     = NULL;
-        tree->left       = NULL;
-        tree->right      = NULL;
-        
-        /* Stores the internal nodes ( in reverse order, so the tree will be the last used node) */
-        nodes[ i ]       = --tree;
+        items[ i ]                     = symbols[ i ]->occurences;
+        kinds[ level * count * 2 + i ] = 1;
     }
     
-    i = 0;
-    j = 0;
-    k = count - 1;
+    lengths[ level ] = count;
     
-    /* Loops to create and connect the symbol nodes */
-    while( i < count - 1 )
+    /* Upper levels - Merges the symbols with pairs of items from the level below */
+    while( level-- > 0 )
     {
-        /* Gets the two next symbols */
-        s1    = *( symbols++ );
-        s2    = *( symbols++ );
-        
-        found = false;
-        i    += 2;
+        previous           = weights + ( level + 1 ) * count * 2;
+        items              = weights + level * count * 2;
+        packages           = lengths[ level + 1 ] / 2;
+        lengths[ level ]   = 0;
+        i                  = 0;
+        j                  = 0;
         
-        /* Process each internal nodes */
-        for( j = 0; j < count - 1; j++ )
+        while( i < count || j < packages )
         {
-            /* Current internal node */
-            node = nodes[ j ];
-            
-            /* Node is not available (already used) */
-            if( node == NULL || node->parent != NULL )
-            {
-                continue;
-            }
+            package = ( j < packages ) ? previous[ j * 2 ] + previous[ j * 2 + 1 ] : 0;
             
-            /* If the node has no occurence number, it's available to use */
-            if( node->occurences == 0 )
+            if( j == packages || ( i < count && symbols[ i ]->occurences <= package ) )
             {
-                /* Stores the node ID */
-                node->id = k--;
-                
-                /* Stores the node left and right children */
-                node->left  = s2;
-                node->right = s1;
-                
-                /* Computes the internal node occurences */
-                node->occurences = s1->occurences + s2->occurences;
-                
-                /* Stores the parent node for the two children */
-                s1->parent = node;
-                s2->parent = node;
-                
-                /* Prints the internal node representation */
-                if( libdebug_is_enabled() == true )
-                {
-                    DEBUG( "Creating new internal node - [%03u]:", node->id );
-                    egz_print_node( node );
-                }
-                
-                /* Nodes have been connected - Next symbols can be processed */
-                break;
+                items[ lengths[ level ] ]                     = symbols[ i++ ]->occurences;
+                kinds[ level * count * 2 + lengths[ level ] ] = 1;
             }
-            
-            /* We have found a connection - Continues until we find an available internal node */
-            else if( found == true && node->occurences != 0 )
+            else
             {
-                continue;
+                items[ lengths[ level ] ]                     = package;
+                kinds[ level * count * 2 + lengths[ level ] ] = 0;
+                j++;
             }
             
-            /* Checks if we can connect the internal node with another internal node */
-            /* This is possible if its occurence number us lower than the second's symbol occurence number  */
-            if( node->occurences < s2->occurences )
-            {
-                /* Sets the pointer to NULL to mark it unavailable */
-                nodes[ j ] = NULL;
-                
-                /* The connection will be made with the internal node instead of the second symbol */
-                s2    = node;
-                found = true;
-                
-                /* Rewinds, as we are not using the second symbol */
-                i--;
-                symbols--;
-            }
+            lengths[ level ]++;
         }
-        
-        found = false;
     }
     
-    /* (Re)Initialization */
-    node = NULL;
-    s1   = NULL;
-    s2   = NULL;
-    s3   = NULL;
-    
-    /* Checks if we still have a symbol not connected to a node */
-    if( i < count )
+    for( i = 0; i < count; i++ )
     {
-        /* Last (not connected) symbol */
-        s3 = *( symbols );
-        DEBUG( "Last symbol: 0x%0X / %u", s3->character, s3->occurences );
+        symbols[ i ]->bits = 0;
     }
     
-    DEBUG( "Connecting final nodes" );
+    /* The first 2n - 2 items of the top level are kept */
+    selected = count * 2 - 2;
     
-    /* No need for the full process if there's only one node left  */
-    if( k == 1 )
+    /* Each kept symbol adds one bit to its code, each kept package keeps two items of the level below */
+    for( level = 0; level < max_bits && selected > 0; level++ )
     {
-        /* Checks if we have a symbol left */
-        if( s3 != NULL )
-        {
-            s1 = s3;
-            s2 = nodes[ j++ ];
-        }
-        else
-        {
-            s1 = nodes[ j - 1 ];
-            s2 = nodes[ j++ ];
-        }
+        leaves   = 0;
+        packages = 0;
         
-        node             = nodes[ j ];
-        node->id         = k--;
-        node->left       = s2;
-        node->right      = s1;
-        s1->parent       = node;
-        s2->parent       = node;
-        node->occurences = s1->occurences + s2->occurences;
-    }
-    else
-    {
-        i = 0;
-        j = 0;
-        
-        while( i < count - 4 )
+        for( i = 0; i < selected; i++ )
         {
-            do
+            if( kinds[ level * count * 2 + i ] == 1 )
             {
-                s1         = nodes[ i ];
-                nodes[ i++ ] = NULL;
-            }
-            while( s1 == NULL );
-            
-            do
-            {
-                s2         = nodes[ i ];
-                nodes[ i++ ] = NULL;
-            }
-            while( s2 == NULL );
-            
-            if( s3 != NULL && s2->occurences >= s3->occurences )
-            {
-                nodes[ --i ] = s2;
-                s2           = s1;
-                s1           = s3;
-                s3           = NULL;
-            }
-            
-            if( j == 0 )
-            {
-                for( j = i; j < count - 1; j++ )
-                {
-                    if( nodes[ j ]->occurences == 0 )
-                    {
-                        node = nodes[ j ];
-                        break;
-                    }
-                }
+                symbols[ leaves++ ]->bits++;
             }
             else
             {
-                node = nodes[ ++j ];
+                packages++;
             }
-            
-            node->id         = k--;
-            node->left       = s1;
-            node->right      = s2;
-            s1->parent       = node;
-            s2->parent       = node;
-            node->occurences = s1->occurences + s2->occurences;
-            
-            if( libdebug_is_enabled() == true )
-            {
-                DEBUG( "Creating new internal node - [%03u]:", node->id );
-                egz_print_node( node );
-            }
-        }
-        
-        if( s3 == NULL )
-        {
-            s1 = nodes[ j - 1 ];
-            s2 = nodes[ j++ ];
-        }
-        else
-        {
-            s1 = s3;
-            s2 = nodes[ j++ ];
         }
         
-        node             = nodes[ j ];
-        node->id         = k--;
-        node->left       = s2;
-        node->right      = s1;
-        s1->parent       = node;
-        s2->parent       = node;
-        node->occurences = s1->occurences + s2->occurences;
+        selected = packages * 2;
     }
     
-    if( libdebug_is_enabled() == true )
-    {
-        DEBUG( "Creating root node - [%03u]:", node->id );
-        egz_print_node( node );
-    }
+    free( weights );
+    free( kinds );
     
-    DEBUG( "Freeing memory" );
-    free( nodes );
-    
-    return tree;
+    return true;
 }
 
 /*!
  * 
  */
-void egz_create_codes( egz_symbol * node, unsigned int depth, uint64_t code )
+void egz_create_canonical_codes( egz_table * table )
 {
-    /* Checks if we have a leaf node */
-    if( node->left == NULL && node->right == NULL )
+    unsigned int i;
+    unsigned int bits;
+    unsigned int counts[ EGZ_BTREE_CODE_MAX_LENGTH + 1 ];
+    uint64_t     codes[ EGZ_BTREE_CODE_MAX_LENGTH + 1 ];
+    uint64_t     code;
+    
+    memset( counts, 0, sizeof( counts ) );
+    memset( codes,  0, sizeof( codes ) );
+    
+    /* Counts the number of codes for each length */
+    for( i = 0; i < 256; i++ )
     {
-        /* Leaf - Stores the depth and the binary code */
-        node->bits = depth;
-        node->code = code;
+        counts[ table->symbols[ i ].bits ]++;
     }
-    else
+    
+    counts[ 0 ] = 0;
+    code        = 0;
+    
+    /* First code of each length - Shorter codes are numerically lower */
+    for( bits = 1; bits <= EGZ_BTREE_CODE_MAX_LENGTH; bits++ )
+    {
+        code          = ( code + counts[ bits - 1 ] ) << 1;
+        codes[ bits ] = code;
+    }
+    
+    /* Assigns the codes of a same length in the symbols order */
+    for( i = 0; i < 256; i++ )
     {
-        /* Node - Creates codes for the left (0) and right (1) children */
-        egz_create_codes( node->left,  depth + 1, ( code << 1 ) );
-        egz_create_codes( node->right, depth + 1, ( code << 1 ) + 1 );
+        bits = table->symbols[ i ].bits;
+        
+        if( bits > 0 )
+        {
+            table->symbols[ i ].code = codes[ bits ]++;
+        }
     }
 }
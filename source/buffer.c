@@ -0,0 +1,401 @@
+/*******************************************************************************
+ * Copyright (c) 2010, Jean-David Gadina - www.xs-labs.com
+ * Distributed under the Boost Software License, Version 1.0.
+ * 
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ * 
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ * 
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ******************************************************************************/
+
+/* $Id$ */
+
+/*!
+ * @file        buffer.c
+ * @copyright   (c) 2011 - Jean-David Gadina - www.xs-labs.com
+ * @abstract    In-memory buffer functions
+ */
+
+/* Local includes */
+#include "egz.h"
+
+/*!
+ * 
+ */
+void egz_options_init( egz_options * options )
+{
+    /* Library defaults - egz_compress() does not print its summary unless quiet is cleared */
+    options->max_code_bits = EGZ_MAX_CODE_BITS_DEFAULT;
+    options->streams       = EGZ_STREAMS_DEFAULT;
+    options->block_size    = EGZ_BLOCK_SIZE_DEFAULT;
+    options->threads       = EGZ_THREADS_DEFAULT;
+    options->streamed      = false;
+    options->adaptive      = false;
+    options->quiet         = true;
+    options->checksum_type = EGZ_CHECKSUM_DEFAULT;
+    options->table_file    = NULL;
+}
+
+/*!
+ * 
+ */
+egz_context * egz_context_create( egz_options * options )
+{
+    egz_context * context;
+    
+    if( NULL == ( context = ( egz_context * )malloc( sizeof( egz_context ) ) ) )
+    {
+        return NULL;
+    }
+    
+    if( options != NULL )
+    {
+        context->options = *( options );
+    }
+    else
+    {
+        egz_options_init( &( context->options ) );
+    }
+    
+    egz_block_init( &( context->block ) );
+    
+    return context;
+}
+
+/*!
+ * 
+ */
+void egz_context_destroy( egz_context * context )
+{
+    if( context == NULL )
+    {
+        return;
+    }
+    
+    egz_block_free( &( context->block ) );
+    free( context );
+}
+
+/*!
+ * 
+ */
+size_t egz_compress_bound( egz_context * context, size_t length )
+{
+    size_t size;
+    size_t blocks;
+    
+    /* Adaptive blocks can be as small as a segment */
+    size   = ( context->options.adaptive == true ) ? EGZ_SPLIT_SEGMENT_LENGTH : context->options.block_size;
+    blocks = ( length + size - 1 ) / size;
+    blocks = ( blocks > 0 ) ? blocks : 1;
+    
+    /* Header + every symbol with the longest code + block header, checksum, table and padded streams for each block */
+    return EGZ_HEADER_MAX_LENGTH
+         + strlen( EGZ_FILE_DATA_ID )
+         + ( length * context->options.max_code_bits + 7 ) / 8
+         + blocks * ( EGZ_BLOCK_HEADER_LENGTH + sizeof( uint32_t ) + 2 + 256 + EGZ_STREAMS_MAX * ( sizeof( uint32_t ) + sizeof( uint64_t ) ) );
+}
+
+/*!
+ * 
+ */
+egz_status egz_compress_buffer( egz_context * context, unsigned char * source, size_t length, unsigned char * destination, size_t capacity, size_t * written )
+{
+    size_t        offset;
+    size_t        block_length;
+    size_t        total;
+    egz_table   * table;
+    egz_symbol ** symbols;
+    egz_digest    digest;
+    egz_status    status;
+    char          hash[ EGZ_CHECKSUM_LENGTH ];
+    
+    *( written ) = 0;
+    
+    if( length == 0 )
+    {
+        return EGZ_ERROR_EMPTY_FILE;
+    }
+    
+    if( NULL == ( table = egz_create_table() ) )
+    {
+        return EGZ_ERROR_MALLOC;
+    }
+    
+    egz_digest_init( &digest, context->options.checksum_type );
+    egz_digest_update( &digest, source, length );
+    egz_digest_final( &digest, hash );
+    egz_count_symbols( table, source, length );
+    
+    /* The symbols are only needed to build the codes */
+    if( NULL == ( symbols = ( egz_symbol ** )malloc( sizeof( egz_symbol * ) * table->count ) ) )
+    {
+        free( table );
+        return EGZ_ERROR_MALLOC;
+    }
+    
+    if( egz_create_table_codes( table, symbols, context->options.max_code_bits ) == false )
+    {
+        free( symbols );
+        free( table );
+        return EGZ_ERROR_MALLOC;
+    }
+    
+    free( symbols );
+    
+    /* Incompressible data - Same empty shared table as egz_compress(), the blocks are stored or get their own tables */
+    if( egz_get_compression_ratio( table ) <= 0 )
+    {
+        free( table );
+        
+        if( NULL == ( table = egz_create_table() ) )
+        {
+            return EGZ_ERROR_MALLOC;
+        }
+    }
+    
+    /* Same layout as a compressed file - Header, then the blocks */
+    if( capacity < EGZ_HEADER_PREFIX_LENGTH + egz_get_header_size( table ) + strlen( EGZ_FILE_DATA_ID ) )
+    {
+        free( table );
+        return EGZ_ERROR_BUFFER_TOO_SMALL;
+    }
+    
+    total  = egz_pack_header( table, EGZ_HEADER_FLAG_BLOCKS | EGZ_HEADER_FLAG_CHECKSUM( context->options.checksum_type ), length, hash, destination );
+    status = EGZ_OK;
+    
+    memcpy( destination + total, EGZ_FILE_DATA_ID, strlen( EGZ_FILE_DATA_ID ) );
+    
+    total += strlen( EGZ_FILE_DATA_ID );
+    
+    for( offset = 0; offset < length; offset += block_length )
+    {
+        if( context->options.adaptive == true )
+        {
+            block_length = egz_split_block( source + offset, length - offset, context->options.block_size );
+        }
+        else
+        {
+            block_length = ( length - offset < context->options.block_size ) ? length - offset : context->options.block_size;
+        }
+        
+        status       = egz_compress_block( source + offset, block_length, table, &( context->options ), &( context->block ) );
+        
+        if( status != EGZ_OK )
+        {
+            break;
+        }
+        
+        if( context->block.length > capacity - total )
+        {
+            status = EGZ_ERROR_BUFFER_TOO_SMALL;
+            break;
+        }
+        
+        memcpy( destination + total, context->block.data, context->block.length );
+        
+        total += context->block.length;
+    }
+    
+    free( table );
+    
+    if( status == EGZ_OK )
+    {
+        *( written ) = total;
+    }
+    
+    return status;
+}
+
+/*!
+ * 
+ */
+egz_status egz_expanded_length( unsigned char * source, size_t length, uint64_t * expanded )
+{
+    egz_header header;
+    
+    if( egz_read_header( source, length, &header ) != EGZ_OK )
+    {
+        return EGZ_ERROR_INVALID_FORMAT;
+    }
+    
+    /* Streamed data - The original size is in the trailer */
+    if( ( header.flags & EGZ_HEADER_FLAG_STREAMED ) != 0 )
+    {
+        if( length < header.length + EGZ_TRAILER_LENGTH )
+        {
+            return EGZ_ERROR_INVALID_FORMAT;
+        }
+        
+        memcpy( expanded, source + length - EGZ_TRAILER_LENGTH, sizeof( uint64_t ) );
+    }
+    else
+    {
+        *( expanded ) = header.original_length;
+    }
+    
+    return EGZ_OK;
+}
+
+/*!
+ * 
+ */
+egz_status egz_expand_buffer( unsigned char * source, size_t length, unsigned char * destination, size_t capacity, size_t * written )
+{
+    bool             streamed;
+    size_t           total;
+    uint64_t         expected;
+    unsigned char  * checksum;
+    unsigned char  * end;
+    egz_header       header;
+    egz_block_header block;
+    egz_lookup     * lookup;
+    egz_digest       digest;
+    egz_status       status;
+    unsigned char    lengths[ 256 ];
+    char             hash[ EGZ_CHECKSUM_LENGTH ];
+    
+    *( written ) = 0;
+    
+    /* Only block files can be expanded in memory */
+    if( egz_read_header( source, length, &header ) != EGZ_OK || header.v1 == true || ( header.flags & EGZ_HEADER_FLAG_BLOCKS ) == 0 )
+    {
+        return EGZ_ERROR_INVALID_FORMAT;
+    }
+    
+    streamed = ( ( header.flags & EGZ_HEADER_FLAG_STREAMED ) != 0 ) ? true : false;
+    expected = header.original_length;
+    checksum = header.checksum;
+    lookup   = NULL;
+    end      = source + length;
+    source  += header.length;
+    
+    if( ( size_t )( end - source ) < strlen( EGZ_FILE_DATA_ID ) || memcmp( source, EGZ_FILE_DATA_ID, strlen( EGZ_FILE_DATA_ID ) ) != 0 )
+    {
+        return EGZ_ERROR_INVALID_FORMAT;
+    }
+    
+    source += strlen( EGZ_FILE_DATA_ID );
+    
+    /* Pre-trained table - Loaded from the search path */
+    if( ( header.flags & EGZ_HEADER_FLAG_TABLE_ID ) != 0 )
+    {
+        if( EGZ_OK != ( status = egz_find_table_lookup( &lookup, header.table_id, NULL ) ) )
+        {
+            return status;
+        }
+    }
+    
+    /* Streamed data has no shared table, nor has incompressible data */
+    else if( streamed == false && ( header.symbols_length < 2 || header.symbols[ 0 ] != 0 || header.symbols[ 1 ] != 0 ) )
+    {
+        if( egz_rebuild_lengths( header.symbols, lengths, header.symbols_length ) == 0 )
+        {
+            return EGZ_ERROR_INVALID_FORMAT;
+        }
+        
+        status = egz_create_canonical_lookup( &lookup, lengths );
+        
+        if( status != EGZ_OK )
+        {
+            return status;
+        }
+    }
+    
+    total  = 0;
+    status = EGZ_OK;
+    
+    while( streamed == true || total < expected )
+    {
+        if( end - source < EGZ_BLOCK_HEADER_LENGTH )
+        {
+            status = EGZ_ERROR_INVALID_FORMAT;
+            break;
+        }
+        
+        /* End of streamed data - The trailer has the original size and checksum */
+        if( streamed == true && egz_block_is_end( source ) == true )
+        {
+            if( end - source < EGZ_BLOCK_HEADER_LENGTH + EGZ_TRAILER_LENGTH )
+            {
+                status = EGZ_ERROR_INVALID_FORMAT;
+                break;
+            }
+            
+            memcpy( &expected, source + EGZ_BLOCK_HEADER_LENGTH, sizeof( uint64_t ) );
+            
+            checksum = source + EGZ_BLOCK_HEADER_LENGTH + sizeof( uint64_t );
+            
+            break;
+        }
+        
+        if( EGZ_OK != ( status = egz_read_block_header( source, &block ) ) )
+        {
+            break;
+        }
+        
+        if( block.original_length == 0 || ( streamed == false && block.original_length > expected - total ) || ( size_t )( end - source ) - EGZ_BLOCK_HEADER_LENGTH < block.payload_length )
+        {
+            status = EGZ_ERROR_INVALID_FORMAT;
+            break;
+        }
+        
+        if( block.original_length > capacity - total )
+        {
+            status = EGZ_ERROR_BUFFER_TOO_SMALL;
+            break;
+        }
+        
+        if( EGZ_OK != ( status = egz_expand_block( source + EGZ_BLOCK_HEADER_LENGTH, &block, lookup, destination + total ) ) )
+        {
+            break;
+        }
+        
+        total  += block.original_length;
+        source += EGZ_BLOCK_HEADER_LENGTH + block.payload_length;
+    }
+    
+    free( lookup );
+    
+    if( status != EGZ_OK )
+    {
+        return status;
+    }
+    
+    if( total != expected || checksum[ EGZ_CHECKSUM_LENGTH - 1 ] != 0 )
+    {
+        return EGZ_ERROR_INVALID_FORMAT;
+    }
+    
+    egz_digest_init( &digest, header.checksum_type );
+    egz_digest_update( &digest, destination, total );
+    egz_digest_final( &digest, hash );
+    
+    if( strcmp( ( char * )checksum, hash ) != 0 )
+    {
+        return EGZ_ERROR_INVALID_CHECKSUM;
+    }
+    
+    *( written ) = total;
+    
+    return EGZ_OK;
+}
@@ -0,0 +1,525 @@
+/*******************************************************************************
+ * Copyright (c) 2010, Jean-David Gadina - www.xs-labs.com
+ * Distributed under the Boost Software License, Version 1.0.
+ * 
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ * 
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ * 
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ******************************************************************************/
+
+/* $Id$ */
+
+/*!
+ * @file        checksum.c
+ * @copyright   (c) 2011 - Jean-David Gadina - www.xs-labs.com
+ * @abstract    Checksum functions (MD5, CRC32C and xxHash64)
+ */
+
+/* Local includes */
+#include "egz.h"
+
+/* Hardware CRC32C - SSE 4.2 on x86-64 (checked at run time), or the ARMv8 CRC extension */
+#if defined( __x86_64__ ) && ( defined( __GNUC__ ) || defined( __clang__ ) )
+    
+    #define EGZ_CRC32C_SSE42
+    
+#elif defined( __aarch64__ ) && defined( __ARM_FEATURE_CRC32 )
+    
+    #include <arm_acle.h>
+    
+    #define EGZ_CRC32C_ARM
+    
+#endif
+
+/* xxHash64 primes */
+#define EGZ_XXH64_PRIME_1   0x9E3779B185EBCA87ULL
+#define EGZ_XXH64_PRIME_2   0xC2B2AE3D27D4EB4FULL
+#define EGZ_XXH64_PRIME_3   0x165667B19E3779F9ULL
+#define EGZ_XXH64_PRIME_4   0x85EBCA77C2B2AE63ULL
+#define EGZ_XXH64_PRIME_5   0x27D4EB2F165667C5ULL
+#define EGZ_XXH64_ROTATE( x, n ) ( ( ( x ) << ( n ) ) | ( ( x ) >> ( 64 - ( n ) ) ) )
+
+/* Private variables */
+static pthread_once_t __crc32c_once     = PTHREAD_ONCE_INIT;
+static bool           __crc32c_hardware = false;
+static uint32_t       __crc32c_table[ 8 ][ 256 ];
+
+/* Private functions */
+static void     egz_crc32c_init( void );
+static uint32_t egz_crc32c_software( uint32_t crc, unsigned char * data, size_t length );
+static uint64_t egz_xxh64_round( uint64_t acc, uint64_t input );
+static uint64_t egz_xxh64_merge( uint64_t acc, uint64_t value );
+static void     egz_xxh64_update( egz_digest * digest, unsigned char * data, size_t length );
+static uint64_t egz_xxh64_final( egz_digest * digest );
+
+#if defined( EGZ_CRC32C_SSE42 )
+
+static uint32_t egz_crc32c_hardware( uint32_t crc, unsigned char * data, size_t length ) __attribute__( ( target( "sse4.2" ) ) );
+
+#endif
+
+/*!
+ * 
+ */
+void egz_md5_digest_to_hex( unsigned char * digest, char * hash )
+{
+    unsigned int i;
+    char         hex[ 3 ] = { 0, 0, 0 };
+    
+    memset( hash, 0, MD5_DIGEST_LENGTH * 2 + 1 );
+    
+    for( i = 0; i < MD5_DIGEST_LENGTH; i++ )
+    {
+        sprintf( hex, "%02x", digest[ i ] );
+        strcat( hash, hex );
+    }
+}
+
+/*!
+ * 
+ */
+void egz_digest_init( egz_digest * digest, unsigned int type )
+{
+    digest->type     = type;
+    digest->length   = 0;
+    digest->buffered = 0;
+    digest->stage    = EGZ_STATS_CHECKSUM;
+    
+    switch( type )
+    {
+        case EGZ_CHECKSUM_MD5:
+            
+            MD5_Init( &( digest->ctx ) );
+            break;
+        
+        case EGZ_CHECKSUM_CRC32C:
+            
+            digest->crc = 0xFFFFFFFF;
+            break;
+        
+        case EGZ_CHECKSUM_XXH64:
+            
+            /* Seed 0 */
+            digest->state[ 0 ] = EGZ_XXH64_PRIME_1 + EGZ_XXH64_PRIME_2;
+            digest->state[ 1 ] = EGZ_XXH64_PRIME_2;
+            digest->state[ 2 ] = 0;
+            digest->state[ 3 ] = 0 - EGZ_XXH64_PRIME_1;
+            break;
+        
+        default:
+            
+            break;
+    }
+}
+
+/*!
+ * 
+ */
+void egz_digest_update( egz_digest * digest, unsigned char * data, size_t length )
+{
+    egz_timer timer;
+    
+    egz_stats_begin( &timer );
+    
+    switch( digest->type )
+    {
+        case EGZ_CHECKSUM_MD5:
+            
+            MD5_Update( &( digest->ctx ), data, length );
+            break;
+        
+        case EGZ_CHECKSUM_CRC32C:
+            
+            digest->crc = egz_crc32c( digest->crc, data, length );
+            break;
+        
+        case EGZ_CHECKSUM_XXH64:
+            
+            egz_xxh64_update( digest, data, length );
+            break;
+        
+        default:
+            
+            break;
+    }
+    
+    digest->length += length;
+    
+    egz_stats_end( &timer, digest->stage, length, 0 );
+}
+
+/*!
+ * 
+ */
+void egz_digest_final( egz_digest * digest, char * hash )
+{
+    unsigned char md5[ MD5_DIGEST_LENGTH ];
+    egz_timer     timer;
+    
+    egz_stats_begin( &timer );
+    
+    /* The hexadecimal digest is padded with zeros, as it is stored in a fixed-size field */
+    memset( hash, 0, EGZ_CHECKSUM_LENGTH );
+    
+    switch( digest->type )
+    {
+        case EGZ_CHECKSUM_MD5:
+            
+            MD5_Final( md5, &( digest->ctx ) );
+            egz_md5_digest_to_hex( md5, hash );
+            break;
+        
+        case EGZ_CHECKSUM_CRC32C:
+            
+            sprintf( hash, "%08lx", ( unsigned long )( digest->crc ^ 0xFFFFFFFF ) );
+            break;
+        
+        case EGZ_CHECKSUM_XXH64:
+            
+            sprintf( hash, "%016llx", ( unsigned long long )egz_xxh64_final( digest ) );
+            break;
+        
+        default:
+            
+            break;
+    }
+    
+    egz_stats_end( &timer, digest->stage, 0, 0 );
+}
+
+/*!
+ * 
+ */
+uint32_t egz_crc32c( uint32_t crc, unsigned char * data, size_t length )
+{
+    #if defined( EGZ_CRC32C_ARM )
+    
+    uint64_t word;
+    
+    #endif
+    
+    pthread_once( &__crc32c_once, egz_crc32c_init );
+    
+    #if defined( EGZ_CRC32C_SSE42 )
+    
+    if( __crc32c_hardware == true )
+    {
+        return egz_crc32c_hardware( crc, data, length );
+    }
+    
+    #elif defined( EGZ_CRC32C_ARM )
+    
+    for( ; length >= sizeof( uint64_t ); length -= sizeof( uint64_t ), data += sizeof( uint64_t ) )
+    {
+        memcpy( &word, data, sizeof( uint64_t ) );
+        
+        crc = __crc32cd( crc, word );
+    }
+    
+    for( ; length > 0; length--, data++ )
+    {
+        crc = __crc32cb( crc, *( data ) );
+    }
+    
+    return crc;
+    
+    #endif
+    
+    return egz_crc32c_software( crc, data, length );
+}
+
+/*!
+ * 
+ */
+bool egz_get_checksum_type( char * name, unsigned int * type )
+{
+    unsigned int i;
+    
+    for( i = EGZ_CHECKSUM_MD5; i <= EGZ_CHECKSUM_NONE; i++ )
+    {
+        if( strcmp( name, egz_get_checksum_name( i ) ) == 0 )
+        {
+            *( type ) = i;
+            
+            return true;
+        }
+    }
+    
+    return false;
+}
+
+/*!
+ * 
+ */
+const char * egz_get_checksum_name( unsigned int type )
+{
+    switch( type )
+    {
+        case EGZ_CHECKSUM_MD5:      return "md5";
+        case EGZ_CHECKSUM_CRC32C:   return "crc32c";
+        case EGZ_CHECKSUM_XXH64:    return "xxh64";
+        case EGZ_CHECKSUM_NONE:     return "none";
+    }
+    
+    return "unknown";
+}
+
+/*!
+ * 
+ */
+static void egz_crc32c_init( void )
+{
+    unsigned int i;
+    unsigned int j;
+    uint32_t     crc;
+    
+    #if defined( EGZ_CRC32C_SSE42 )
+    
+    __builtin_cpu_init();
+    
+    __crc32c_hardware = ( __builtin_cpu_supports( "sse4.2" ) ) ? true : false;
+    
+    #endif
+    
+    /* Slicing-by-8 tables - The first one is the usual byte table */
+    for( i = 0; i < 256; i++ )
+    {
+        crc = i;
+        
+        for( j = 0; j < 8; j++ )
+        {
+            crc = ( crc >> 1 ) ^ ( ( crc & 1 ) ? EGZ_CRC32C_POLYNOMIAL : 0 );
+        }
+        
+        __crc32c_table[ 0 ][ i ] = crc;
+    }
+    
+    for( i = 0; i < 256; i++ )
+    {
+        for( j = 1; j < 8; j++ )
+        {
+            __crc32c_table[ j ][ i ] = ( __crc32c_table[ j - 1 ][ i ] >> 8 ) ^ __crc32c_table[ 0 ][ __crc32c_table[ j - 1 ][ i ] & 0xFF ];
+        }
+    }
+}
+
+/*!
+ * 
+ */
+static uint32_t egz_crc32c_software( uint32_t crc, unsigned char * data, size_t length )
+{
+    uint32_t low;
+    uint32_t high;
+    
+    /* Eight bytes per step (the words are read as little-endian) */
+    for( ; length >= 8; length -= 8, data += 8 )
+    {
+        memcpy( &low,  data,     sizeof( uint32_t ) );
+        memcpy( &high, data + 4, sizeof( uint32_t ) );
+        
+        low ^= crc;
+        crc  = __crc32c_table[ 7 ][ low         & 0xFF ]
+             ^ __crc32c_table[ 6 ][ ( low >>  8 ) & 0xFF ]
+             ^ __crc32c_table[ 5 ][ ( low >> 16 ) & 0xFF ]
+             ^ __crc32c_table[ 4 ][ low >> 24 ]
+             ^ __crc32c_table[ 3 ][ high        & 0xFF ]
+             ^ __crc32c_table[ 2 ][ ( high >>  8 ) & 0xFF ]
+             ^ __crc32c_table[ 1 ][ ( high >> 16 ) & 0xFF ]
+             ^ __crc32c_table[ 0 ][ high >> 24 ];
+    }
+    
+    for( ; length > 0; length--, data++ )
+    {
+        crc = ( crc >> 8 ) ^ __crc32c_table[ 0 ][ ( crc ^ *( data ) ) & 0xFF ];
+    }
+    
+    return crc;
+}
+
+#if defined( EGZ_CRC32C_SSE42 )
+
+/*!
+ * 
+ */
+static uint32_t egz_crc32c_hardware( uint32_t crc, unsigned char * data, size_t length )
+{
+    uint64_t crc64;
+    uint64_t word;
+    
+    crc64 = crc;
+    
+    for( ; length >= sizeof( uint64_t ); length -= sizeof( uint64_t ), data += sizeof( uint64_t ) )
+    {
+        memcpy( &word, data, sizeof( uint64_t ) );
+        
+        crc64 = __builtin_ia32_crc32di( crc64, word );
+    }
+    
+    crc = ( uint32_t )crc64;
+    
+    for( ; length > 0; length--, data++ )
+    {
+        crc = __builtin_ia32_crc32qi( crc, *( data ) );
+    }
+    
+    return crc;
+}
+
+#endif
+
+/*!
+ * 
+ */
+static uint64_t egz_xxh64_round( uint64_t acc, uint64_t input )
+{
+    acc += input * EGZ_XXH64_PRIME_2;
+    acc  = EGZ_XXH64_ROTATE( acc, 31 );
+    
+    return acc * EGZ_XXH64_PRIME_1;
+}
+
+/*!
+ * 
+ */
+static uint64_t egz_xxh64_merge( uint64_t acc, uint64_t value )
+{
+    acc ^= egz_xxh64_round( 0, value );
+    
+    return acc * EGZ_XXH64_PRIME_1 + EGZ_XXH64_PRIME_4;
+}
+
+/*!
+ * 
+ */
+static void egz_xxh64_update( egz_digest * digest, unsigned char * data, size_t length )
+{
+    size_t   needed;
+    uint64_t lanes[ 4 ];
+    
+    /* Completes the stripe left by the previous update */
+    if( digest->buffered > 0 )
+    {
+        needed = 32 - digest->buffered;
+        needed = ( length < needed ) ? length : needed;
+        
+        memcpy( digest->buffer + digest->buffered, data, needed );
+        
+        digest->buffered += needed;
+        data             += needed;
+        length           -= needed;
+        
+        if( digest->buffered < 32 )
+        {
+            return;
+        }
+        
+        memcpy( lanes, digest->buffer, 32 );
+        
+        digest->state[ 0 ] = egz_xxh64_round( digest->state[ 0 ], lanes[ 0 ] );
+        digest->state[ 1 ] = egz_xxh64_round( digest->state[ 1 ], lanes[ 1 ] );
+        digest->state[ 2 ] = egz_xxh64_round( digest->state[ 2 ], lanes[ 2 ] );
+        digest->state[ 3 ] = egz_xxh64_round( digest->state[ 3 ], lanes[ 3 ] );
+        digest->buffered   = 0;
+    }
+    
+    /* Four independent lanes of 8 bytes per stripe */
+    for( ; length >= 32; length -= 32, data += 32 )
+    {
+        memcpy( lanes, data, 32 );
+        
+        digest->state[ 0 ] = egz_xxh64_round( digest->state[ 0 ], lanes[ 0 ] );
+        digest->state[ 1 ] = egz_xxh64_round( digest->state[ 1 ], lanes[ 1 ] );
+        digest->state[ 2 ] = egz_xxh64_round( digest->state[ 2 ], lanes[ 2 ] );
+        digest->state[ 3 ] = egz_xxh64_round( digest->state[ 3 ], lanes[ 3 ] );
+    }
+    
+    memcpy( digest->buffer, data, length );
+    
+    digest->buffered = length;
+}
+
+/*!
+ * 
+ */
+static uint64_t egz_xxh64_final( egz_digest * digest )
+{
+    uint64_t        hash;
+    uint64_t        word;
+    uint32_t        half;
+    unsigned char * p;
+    size_t          length;
+    
+    if( digest->length >= 32 )
+    {
+        hash = EGZ_XXH64_ROTATE( digest->state[ 0 ], 1 )
+             + EGZ_XXH64_ROTATE( digest->state[ 1 ], 7 )
+             + EGZ_XXH64_ROTATE( digest->state[ 2 ], 12 )
+             + EGZ_XXH64_ROTATE( digest->state[ 3 ], 18 );
+        hash = egz_xxh64_merge( hash, digest->state[ 0 ] );
+        hash = egz_xxh64_merge( hash, digest->state[ 1 ] );
+        hash = egz_xxh64_merge( hash, digest->state[ 2 ] );
+        hash = egz_xxh64_merge( hash, digest->state[ 3 ] );
+    }
+    else
+    {
+        hash = EGZ_XXH64_PRIME_5;
+    }
+    
+    hash  += digest->length;
+    p      = digest->buffer;
+    length = digest->buffered;
+    
+    /* Remaining bytes, by 8, 4, then 1 */
+    for( ; length >= 8; length -= 8, p += 8 )
+    {
+        memcpy( &word, p, sizeof( uint64_t ) );
+        
+        hash ^= egz_xxh64_round( 0, word );
+        hash  = EGZ_XXH64_ROTATE( hash, 27 ) * EGZ_XXH64_PRIME_1 + EGZ_XXH64_PRIME_4;
+    }
+    
+    if( length >= 4 )
+    {
+        memcpy( &half, p, sizeof( uint32_t ) );
+        
+        hash   ^= ( uint64_t )half * EGZ_XXH64_PRIME_1;
+        hash    = EGZ_XXH64_ROTATE( hash, 23 ) * EGZ_XXH64_PRIME_2 + EGZ_XXH64_PRIME_3;
+        p      += 4;
+        length -= 4;
+    }
+    
+    for( ; length > 0; length--, p++ )
+    {
+        hash ^= ( uint64_t )*( p ) * EGZ_XXH64_PRIME_5;
+        hash  = EGZ_XXH64_ROTATE( hash, 11 ) * EGZ_XXH64_PRIME_1;
+    }
+    
+    /* Avalanche */
+    hash ^= hash >> 33;
+    hash *= EGZ_XXH64_PRIME_2;
+    hash ^= hash >> 29;
+    hash *= EGZ_XXH64_PRIME_3;
+    hash ^= hash >> 32;
+    
+    return hash;
+}
@@ -38,28 +38,52 @@
 /* Local includes */
 #include "egz.h"
 
-/* Private variables */
-static unsigned int __percent = 0;
+/* Private functions */
+static egz_status egz_compress_job( egz_job * job, void * context );
 
 /*!
  * 
  */
-egz_status egz_compress( FILE * source, FILE * destination, bool force )
+egz_status egz_compress( FILE * source, FILE * destination, egz_options * options )
 {
-    unsigned int  i;
-    unsigned int  j;
     double        size_original;
     double        size_compressed;
     double        ratio;
+    long          base;
+    unsigned long length;
     char          unit_original[ 3 ];
     char          unit_compressed[ 3 ];
     egz_table  *  table;
-    egz_symbol *  tree;
+    egz_table  *  shared;
     egz_symbol ** symbols;
+    egz_mapping * input;
+    egz_mapping   mapping;
+    egz_digest    digest;
     egz_status    status;
-    char          md5[ MD5_DIGEST_LENGTH * 2 + 1 ];
+    egz_timer     timer;
+    char          checksum[ EGZ_CHECKSUM_LENGTH ];
+    
+    /* Pipes cannot be read twice - The source is compressed in a single pass */
+    if( options->streamed == true )
+    {
+        return egz_compress_streamed( source, destination, options );
+    }
+    
+    /* Pre-trained table - The symbols do not need to be counted */
+    if( options->table_file != NULL )
+    {
+        return egz_compress_trained( source, destination, options );
+    }
+    
+    memset( checksum, 0, EGZ_CHECKSUM_LENGTH );
+    
+    /* The stream may not start at the beginning of the destination */
+    base = ftell( destination );
     
-    memset( md5, 0, MD5_DIGEST_LENGTH * 2 + 1 );
+    /* Regular files are mapped once, and every pass reads the mapping */
+    input = ( egz_map_file( source, &mapping ) == true ) ? &mapping : NULL;
+    
+    DEBUG( "Source file is %s", ( input != NULL ) ? "memory-mapped" : "read with buffered reads" );
     
     /* Creates the symbol table */
     DEBUG( "Creating the symbols table" );
@@ -68,16 +92,23 @@ egz_status egz_compress( FILE * source, FILE * destination, bool force )
     /* Error - The table was not created */
     if( table == NULL )
     {
+        egz_unmap_file( &mapping );
         return EGZ_ERROR_MALLOC;
     }
     
     /* Gets the symbols from the source file */
-    DEBUG( "Getting all symbols from the source file" );
-    egz_get_symbols( table, source );
+    DEBUG( "Getting all symbols and the %s checksum from the source file", egz_get_checksum_name( options->checksum_type ) );
+    egz_stats_begin( &timer );
+    egz_digest_init( &digest, options->checksum_type );
+    egz_get_symbols( table, source, input, &digest );
+    egz_digest_final( &digest, checksum );
+    egz_stats_end( &timer, EGZ_STATS_HISTOGRAM, table->total, 0 );
     
     /* No symbols - Why compress an empty file? */
     if( table->count == 0 )
     {
+        egz_unmap_file( &mapping );
+        free( table );
         return EGZ_ERROR_EMPTY_FILE;
     }
     
@@ -91,27 +122,22 @@ egz_status egz_compress( FILE * source, FILE * destination, bool force )
     /* Allocates memory to store pointers to the symbols */
     if( NULL == ( symbols = ( egz_symbol ** )malloc( sizeof( egz_symbol * ) * table->count ) ) )
     {
+        egz_unmap_file( &mapping );
         free( table );
         return EGZ_ERROR_MALLOC;
     }
     
-    j = 0;
+    /* Code lengths are computed directly, bounded by the maximum code length */
+    DEBUG( "Determining canonical symbol codes (max %u bits)", options->max_code_bits );
     
-    /* Process each ASCII character */
-    for( i = 0; i < 256; i++ )
+    if( egz_create_table_codes( table, symbols, options->max_code_bits ) == false )
     {
-        /* Checks if the character was present in the file */
-        if( table->symbols[ i ].occurences > 0 )
-        {
-            /* Stores a pointer to the symbol structure */
-            symbols[ j++ ] = &( table->symbols[ i ] );
-        }
+        egz_unmap_file( &mapping );
+        free( symbols );
+        free( table );
+        return EGZ_ERROR_MALLOC;
     }
     
-    /* Sorts the symbols by their frequency */
-    DEBUG( "Ordering the symbols by their frequency" );
-    egz_sort_symbols_by_occurences( symbols, 0, table->count - 1 );
-    
     /* Prints the list of the ordered symbols */
     if( libdebug_is_enabled() == true )
     {
@@ -119,32 +145,6 @@ egz_status egz_compress( FILE * source, FILE * destination, bool force )
         egz_print_symbols( symbols, table->count );
     }
     
-    DEBUG( "Creating the binary tree of symbols" );
-    
-    /* No need for a tree if there is only one symbol */
-    if( table->count > 1 )
-    {
-        /* Creates the binary tree (usual algorithm) */
-        tree = egz_create_btree( symbols, table->count );
-        
-        /* Error - The tree was not created */
-        if( tree == NULL )
-        {
-            free( symbols );
-            free( table );
-            return EGZ_ERROR_MALLOC;
-        }
-    }
-    else
-    {
-        /* One symbol, so the tree is that symbol */
-        tree = *( symbols );
-    }
-    
-    /* Creates the binary codes for each symbol of the tree */
-    DEBUG( "Determining symbol codes" );
-    egz_create_codes( tree, 0, 0 );
-    
     /* Prints the symbol binary codes */
     if( libdebug_is_enabled() == true )
     {
@@ -154,29 +154,25 @@ egz_status egz_compress( FILE * source, FILE * destination, bool force )
         egz_print_statistics( symbols, table->count );
     }
     
-    if( force == false )
+    shared = table;
+    
+    /* Incompressible file - No shared table is written, so the blocks are stored or get their own tables */
+    if( egz_get_compression_ratio( table ) <= 0 )
     {
-        DEBUG( "Checking final compression ratio" );
-        status = egz_check_compression_ratio( table );
+        DEBUG( "The shared table would expand the file - Writing an empty one" );
         
-        if( status != EGZ_OK )
+        if( NULL == ( shared = egz_create_table() ) )
         {
-            DEBUG( "Freeing memory" );
-            
-            if( table->count > 1 )
-            {
-                free( tree );
-            }
-            
+            egz_unmap_file( &mapping );
             free( table );
             free( symbols );
             
-            return status;
+            return EGZ_ERROR_MALLOC;
         }
     }
     
     DEBUG( "Writing file header" );
-    egz_write_header( source, destination, table );
+    egz_write_header( source, destination, shared, EGZ_HEADER_FLAG_BLOCKS | EGZ_HEADER_FLAG_CHECKSUM( options->checksum_type ), checksum );
     
     /* Prints the header as hexadecimal */
     if( libdebug_is_enabled() == true )
@@ -186,33 +182,51 @@ egz_status egz_compress( FILE * source, FILE * destination, bool force )
     }
     
     DEBUG( "Compressing file" );
-    egz_write_compressed_file( source, destination, table );
-    egz_file_md5_checksum( source, md5 );
+    
+    status = egz_write_compressed_blocks( source, destination, ( shared == table ) ? table : NULL, input, NULL, options );
+    
+    egz_unmap_file( &mapping );
+    
+    if( shared != table )
+    {
+        free( shared );
+    }
+    
+    if( status != EGZ_OK )
+    {
+        free( table );
+        free( symbols );
+        
+        return status;
+    }
     
     size_original   = egz_getfilesize_human( source, unit_original );
     size_compressed = egz_getfilesize_human( destination, unit_compressed );
-    ratio           = egz_get_compression_ratio( table );
-    
-    printf
-    (
-        "Original file size:     %.2f %s\n"
-        "Compressed file size:   %.2f %s\n"
-        "Compression ratio:      %.2f %%\n"
-        "Original file checksum: %s\n",
-        size_original,
-        unit_original,
-        size_compressed,
-        unit_compressed,
-        ratio,
-        md5
-    );
-    DEBUG( "Freeing memory" );
+    length          = egz_getfilesize( destination ) - ( unsigned long )base;
+    
+    /* Blocks may have their own tables - The ratio is taken from the actual sizes */
+    ratio = 100 - ( ( double )length / ( double )table->total ) * 100;
     
-    if( table->count > 1 )
+    /* The batch mode reports each file on its own line */
+    if( options->quiet == false )
     {
-        free( tree );
+        printf
+        (
+            "Original file size:     %.2f %s\n"
+            "Compressed file size:   %.2f %s\n"
+            "Compression ratio:      %.2f %%\n"
+            "Original file checksum: %s %s\n",
+            size_original,
+            unit_original,
+            size_compressed,
+            unit_compressed,
+            ratio,
+            egz_get_checksum_name( options->checksum_type ),
+            checksum
+        );
     }
     
+    DEBUG( "Freeing memory" );
     free( table );
     free( symbols );
     
@@ -220,107 +234,215 @@ egz_status egz_compress( FILE * source, FILE * destination, bool force )
 }
 
 /*!
- *
+ * 
  */
-uint16_t egz_get_header_size( egz_table * table )
+egz_status egz_compress_streamed( FILE * source, FILE * destination, egz_options * options )
 {
-    static uint16_t size = 0;
-    unsigned int    i;
+    uint64_t      length;
+    egz_table   * table;
+    egz_digest    digest;
+    egz_status    status;
+    unsigned char end[ EGZ_BLOCK_HEADER_LENGTH ];
+    char          checksum[ EGZ_CHECKSUM_LENGTH ];
+    
+    memset( checksum, 0, EGZ_CHECKSUM_LENGTH );
+    memset( end, 0, EGZ_BLOCK_HEADER_LENGTH );
     
-    if( size > 0 )
+    /* Empty table - The header has no size, no checksum and no shared codes, so every block has its own table */
+    if( NULL == ( table = egz_create_table() ) )
     {
-        return size;
+        return EGZ_ERROR_MALLOC;
     }
     
-    /* Number of symbols + original file size + MD5 checksum */
-    size = 43;
+    /* Pre-trained table - Only its ID is written, and the blocks can share it */
+    if( options->table_file != NULL && EGZ_OK != ( status = egz_load_table( table, options->table_file ) ) )
+    {
+        free( table );
+        return status;
+    }
     
-    for( i = 0; i < 256; i++ )
+    DEBUG( "Writing streamed file header" );
+    egz_write_header( source, destination, table, EGZ_HEADER_FLAG_BLOCKS | EGZ_HEADER_FLAG_STREAMED | EGZ_HEADER_FLAG_CHECKSUM( options->checksum_type ), checksum );
+    
+    DEBUG( "Compressing stream" );
+    egz_digest_init( &digest, options->checksum_type );
+    
+    status = egz_write_compressed_blocks( source, destination, ( table->id != 0 ) ? table : NULL, NULL, &digest, options );
+    
+    free( table );
+    
+    if( status != EGZ_OK )
     {
-        if( table->symbols[ i ].bits > 0 )
-        {
-            size += 2;
-            
-            if( table->symbols[ i ].bits > 32 )
-            {
-                size += 8;
-            }
-            else if( table->symbols[ i ].bits > 16 )
-            {
-                size += 4;
-            }
-            else if( table->symbols[ i ].bits > 8 )
-            {
-                size += 2;
-            }
-            else
-            {
-                size += 1;
-            }
-        }
+        return status;
+    }
+    
+    if( digest.length == 0 )
+    {
+        return EGZ_ERROR_EMPTY_FILE;
+    }
+    
+    egz_digest_final( &digest, checksum );
+    
+    length = digest.length;
+    
+    /* Trailer - An empty block header, then the original size and checksum */
+    fwrite( end,      sizeof( unsigned char ), EGZ_BLOCK_HEADER_LENGTH, destination );
+    fwrite( &length,  sizeof( uint64_t ),      1,                       destination );
+    fwrite( checksum, sizeof( char ),          EGZ_CHECKSUM_LENGTH,     destination );
+    
+    if( options->quiet == false )
+    {
+        printf
+        (
+            "Original file size:     %.2f MB\n"
+            "Original file checksum: %s %s\n",
+            ( ( double )length / ( double )1000 ) / ( double )1000,
+            egz_get_checksum_name( options->checksum_type ),
+            checksum
+        );
     }
     
-    return size;
+    return EGZ_OK;
 }
 
 /*!
  * 
  */
-egz_status egz_check_compression_ratio( egz_table * table )
+egz_status egz_compress_trained( FILE * source, FILE * destination, egz_options * options )
 {
-    unsigned char c;
-    char          answer[ 1 ];
-    unsigned long bits_original;
-    unsigned long bits_compressed;
-    unsigned long bytes_original;
-    unsigned long bytes_compressed;
-    egz_symbol  * symbol;
+    double        size_original;
+    double        size_compressed;
+    long          base;
+    unsigned long length;
+    char          unit_original[ 3 ];
+    char          unit_compressed[ 3 ];
+    egz_table   * table;
+    egz_mapping * input;
+    egz_mapping   mapping;
+    egz_digest    digest;
+    egz_status    status;
+    char          checksum[ EGZ_CHECKSUM_LENGTH ];
     
-    bits_original   = 0;
-    bits_compressed = 0;
+    memset( checksum, 0, EGZ_CHECKSUM_LENGTH );
     
-    /* Process each symbol */
-    for( c = 0; c < 255; c++ )
+    if( NULL == ( table = egz_create_table() ) )
     {
-        /* Current symbol */
-        symbol = &( table->symbols[ c ] );
-        
-        if( symbol->bits > 0 )
-        {
-            /* Adds the number of bits used to represent the symbol in the original file */
-            bits_original   += 8 * symbol->occurences;
-            
-            /* Adds the number of bits used to represent the symbol in the compressed file */
-            bits_compressed += symbol->bits * symbol->occurences;
-        }
+        return EGZ_ERROR_MALLOC;
     }
     
-    bytes_original    = bits_original   / 8;
-    bytes_compressed  = bits_compressed / 8;
-    bytes_compressed += egz_get_header_size( table );
+    DEBUG( "Loading the pre-trained table: %s", options->table_file );
     
-    DEBUG( "Original file:                 %lu bytes", bytes_original );
-    DEBUG( "Compressed file (with header): %lu bytes", bytes_compressed );
+    if( EGZ_OK != ( status = egz_load_table( table, options->table_file ) ) )
+    {
+        free( table );
+        return status;
+    }
     
-    if( bytes_original < bytes_compressed )
+    input = ( egz_map_file( source, &mapping ) == true ) ? &mapping : NULL;
+    
+    /* The stream may not start at the beginning of the destination */
+    base = ftell( destination );
+    
+    /* The checksum is not known yet - It is written once the blocks are compressed */
+    DEBUG( "Writing file header (table %016llx)", ( unsigned long long )table->id );
+    egz_write_header( source, destination, table, EGZ_HEADER_FLAG_BLOCKS | EGZ_HEADER_FLAG_CHECKSUM( options->checksum_type ), checksum );
+    
+    DEBUG( "Compressing file" );
+    egz_digest_init( &digest, options->checksum_type );
+    
+    status = egz_write_compressed_blocks( source, destination, table, input, &digest, options );
+    
+    egz_unmap_file( &mapping );
+    free( table );
+    
+    if( status != EGZ_OK )
+    {
+        return status;
+    }
+    
+    if( digest.length == 0 )
+    {
+        return EGZ_ERROR_EMPTY_FILE;
+    }
+    
+    egz_digest_final( &digest, checksum );
+    
+    fseek( destination, base + EGZ_HEADER_PREFIX_LENGTH + 1 + sizeof( uint64_t ), SEEK_SET );
+    fwrite( checksum, sizeof( char ), EGZ_CHECKSUM_LENGTH, destination );
+    fseek( destination, 0, SEEK_END );
+    
+    size_original   = egz_getfilesize_human( source, unit_original );
+    size_compressed = egz_getfilesize_human( destination, unit_compressed );
+    length          = egz_getfilesize( destination ) - ( unsigned long )base;
+    
+    if( options->quiet == false )
     {
         printf
         (
-            "Warning: the compressed file will be larger than the original file.\n"
-            "Do you still want to continue? [y/N]\n"
+            "Original file size:     %.2f %s\n"
+            "Compressed file size:   %.2f %s\n"
+            "Compression ratio:      %.2f %%\n"
+            "Original file checksum: %s %s\n",
+            size_original,
+            unit_original,
+            size_compressed,
+            unit_compressed,
+            100 - ( ( double )length / ( double )digest.length ) * 100,
+            egz_get_checksum_name( options->checksum_type ),
+            checksum
         );
-        
-        scanf( "%c", answer );
-        
-        if( *( answer ) != 'y' && *( answer ) != 'Y' )
-        {
-            return EGZ_ERROR_ABORT;
-        }
     }
     
     return EGZ_OK;
 }
 
+/*!
+ *
+ */
+uint16_t egz_get_header_size( egz_table * table )
+{
+    /* Options + original file size + checksum + code lengths, or the ID of a pre-trained table */
+    return 42 + ( ( table->id != 0 ) ? sizeof( uint64_t ) : egz_get_lengths_size( table ) );
+}
+
+/*!
+ *
+ */
+uint16_t egz_get_lengths_size( egz_table * table )
+{
+    /* Number of symbols + code lengths, either as (symbol, length) pairs or as a full table */
+    return ( table->count > EGZ_HEADER_LENGTHS_PAIRS ) ? 2 + 256 : 2 + table->count * 2;
+}
+
+/*!
+ *
+ */
+void egz_pack_lengths( egz_table * table, unsigned char * buffer )
+{
+    unsigned int i;
+    uint16_t     count;
+    
+    count = ( uint16_t )table->count;
+    
+    memcpy( buffer, &count, sizeof( uint16_t ) );
+    
+    buffer += sizeof( uint16_t );
+    
+    /* Canonical codes - Only the code lengths are stored */
+    for( i = 0; i < 256; i++ )
+    {
+        if( table->count > EGZ_HEADER_LENGTHS_PAIRS )
+        {
+            *( buffer++ ) = ( unsigned char )table->symbols[ i ].bits;
+        }
+        else if( table->symbols[ i ].bits > 0 )
+        {
+            *( buffer++ ) = table->symbols[ i ].character;
+            *( buffer++ ) = ( unsigned char )table->symbols[ i ].bits;
+        }
+    }
+}
+
 /*!
  * 
  */
@@ -362,223 +484,229 @@ double egz_get_compression_ratio( egz_table * table )
     return ratio;
 }
 
-egz_status egz_write_header( FILE * source, FILE * destination, egz_table * table )
+egz_status egz_write_header( FILE * source, FILE * destination, egz_table * table, uint8_t flags, char * checksum )
 {
-    unsigned int    i;
-    uint16_t        header_size;
     uint64_t        file_size;
-    char          * md5;
-    unsigned char * header;
+    size_t          length;
+    egz_timer       timer;
+    unsigned char   header[ EGZ_HEADER_MAX_LENGTH ];
     
-    header_size = egz_get_header_size( table );
-    file_size   = egz_getfilesize( source );
+    egz_stats_begin( &timer );
     
-    if( NULL == ( md5 = ( char * )calloc( sizeof( char ), ( MD5_DIGEST_LENGTH * 2 + 1 ) ) ) )
-    {
-        return EGZ_ERROR_MALLOC;
-    }
+    file_size = ( ( flags & EGZ_HEADER_FLAG_STREAMED ) != 0 ) ? 0 : egz_getfilesize( source );
     
-    if( NULL == ( header = ( unsigned char * )calloc( sizeof( unsigned char ), header_size + 5 ) ) )
-    {
-        return EGZ_ERROR_MALLOC;
-    }
+    /* The checksum was computed while getting the symbols */
+    DEBUG( "Checksum: %s", checksum );
+    
+    length = egz_pack_header( table, flags, file_size, checksum, header );
+    
+    fwrite( header, sizeof( unsigned char ), length, destination );
+    
+    egz_stats_end( &timer, EGZ_STATS_HEADER, 0, length );
+    
+    return EGZ_OK;
+}
 
-    fwrite( EGZ_FILE_ID,        sizeof( uint8_t ),  strlen( EGZ_FILE_ID ),        destination );
-    fwrite( &header_size,       sizeof( uint16_t ), 1,                            destination );
-    fwrite( EGZ_FILE_HEADER_ID, sizeof( uint8_t ),  strlen( EGZ_FILE_HEADER_ID ), destination );
-    fwrite( &file_size,         sizeof( uint64_t ), 1,                            destination );
+/*!
+ * 
+ */
+size_t egz_pack_header( egz_table * table, uint8_t flags, uint64_t file_size, char * checksum, unsigned char * buffer )
+{
+    uint16_t        header_size;
+    unsigned char * p;
+    
+    header_size = egz_get_header_size( table );
+    flags       = ( table->id != 0 ) ? flags | EGZ_HEADER_FLAG_TABLE_ID : flags;
+    p           = buffer;
     
-    DEBUG( "Getting source file MD5 checksum" );
-    egz_file_md5_checksum( source, md5 );
-    DEBUG( "MD5 checksum: %s", md5 );
-    fwrite( md5, sizeof( char ), MD5_DIGEST_LENGTH * 2 + 1, destination );
-    free( md5 );
+    /* Signature, header length and header ID */
+    memcpy( p, EGZ_FILE_ID, strlen( EGZ_FILE_ID ) );
+    memcpy( p + 3, &header_size, sizeof( uint16_t ) );
+    memcpy( p + 5, EGZ_FILE_HEADER_ID, strlen( EGZ_FILE_HEADER_ID ) );
     
-    fwrite( &( table->count ), sizeof( unsigned short ), 1, destination );
+    p += EGZ_HEADER_PREFIX_LENGTH;
     
-    for( i = 0; i < 256; i++ )
+    /* Options, original file size and checksum */
+    memcpy( p, &flags, sizeof( uint8_t ) );
+    memcpy( p + 1, &file_size, sizeof( uint64_t ) );
+    memcpy( p + 9, checksum, EGZ_CHECKSUM_LENGTH );
+    
+    p += 42;
+    
+    /* Pre-trained table - The decoder loads it from its ID */
+    if( table->id != 0 )
     {
-        if( table->symbols[ i ].bits > 0 )
-        {
-            fwrite( &( table->symbols[ i ].character ), sizeof( unsigned char ), 1, destination );
-            fwrite( &( table->symbols[ i ].bits      ), sizeof( unsigned char ), 1, destination );
-            
-            if( table->symbols[ i ].bits > 32 )
-            {
-                fwrite( &( table->symbols[ i ].code ), sizeof( uint64_t ), 1, destination );
-            }
-            else if( table->symbols[ i ].bits > 16 )
-            {
-                fwrite( &( table->symbols[ i ].code ), sizeof( uint32_t ), 1, destination );
-            }
-            else if( table->symbols[ i ].bits > 8 )
-            {
-                fwrite( &( table->symbols[ i ].code ), sizeof( uint16_t ), 1, destination );
-            }
-            else
-            {
-                fwrite( &( table->symbols[ i ].code ), sizeof( uint8_t ), 1, destination );
-            }
-        }
+        memcpy( p, &( table->id ), sizeof( uint64_t ) );
+    }
+    else
+    {
+        egz_pack_lengths( table, p );
     }
     
-    free( header );
-    
-    return EGZ_OK;
+    return EGZ_HEADER_PREFIX_LENGTH + header_size;
 }
 
 /*!
  * 
  */
-egz_status egz_write_compressed_file( FILE * source, FILE * destination, egz_table * table )
+egz_status egz_write_compressed_blocks( FILE * source, FILE * destination, egz_table * table, egz_mapping * mapping, egz_digest * digest, egz_options * options )
 {
-    unsigned int        num_bits;
-    unsigned int        length;
-    unsigned int        i;
-    unsigned int        j;
-    unsigned long       size;
-    unsigned long       read_ops;
-    unsigned long       read_op;
-    long                offset;
-    unsigned char       c;
-    unsigned char       read_buffer[ EGZ_READ_BUFFER_LENGTH ];
-    unsigned char       symbol_buffer[ sizeof( uint64_t ) ];
-    uint64_t            write_buffer[ EGZ_WRITE_BUFFER_LENGTH ];
-    uint64_t          * data;
-    egz_symbol        * s;
-    libprogressbar_args args;
-    
-    j         = 0;
-    num_bits  = 0;
-    data      = ( uint64_t * )( &( symbol_buffer[ 0 ] ) );
-    s         = NULL;
-    offset    = ftell( source );
-    size      = egz_getfilesize( source );
-    read_ops  = ceil( ( double )size / ( double )EGZ_READ_BUFFER_LENGTH );
-    read_op   = 0;
-    __percent = 0;
-    
-    if( libdebug_is_enabled() == false )
+    bool              eof;
+    long              offset;
+    size_t            position;
+    size_t            length;
+    unsigned long     size;
+    unsigned long     read_op;
+    unsigned long     bytes;
+    uint64_t          written;
+    egz_pool        * pool;
+    egz_job         * job;
+    egz_block         carry;
+    egz_block_context context;
+    egz_status        status;
+    egz_timer         timer;
+    
+    egz_stats_begin( &timer );
+    
+    eof             = false;
+    status          = EGZ_OK;
+    offset          = ftell( source );
+    size            = ( options->streamed == true ) ? 0 : egz_getfilesize( source );
+    read_op         = 0;
+    bytes           = 0;
+    written         = strlen( EGZ_FILE_DATA_ID );
+    position        = 0;
+    context.table   = table;
+    context.lookup  = NULL;
+    context.options = options;
+    
+    DEBUG( "Compressing %s blocks with %u thread(s)", ( options->adaptive == true ) ? "adaptive" : "fixed-size", options->threads );
+    
+    egz_block_init( &carry );
+    
+    /* Data read after an adaptive split is kept for the next block */
+    if( options->adaptive == true && mapping == NULL && egz_block_reserve( &carry, options->block_size ) == false )
     {
-        args.percent = &__percent;
-        args.length  = 50;
-        args.label   = "Compressing file:      ";
-        args.done    = "[OK]";
-        
-        libprogressbar_create_progressbar( ( void * )( &args ) );
+        return EGZ_ERROR_MALLOC;
     }
     
+    if( NULL == ( pool = egz_pool_create( options->threads, egz_compress_job, &context ) ) )
+    {
+        egz_block_free( &carry );
+        return EGZ_ERROR_MALLOC;
+    }
+    
+    egz_progress_begin( EGZ_PROGRESS_COMPRESS, size );
+    
     fseek( source, 0, SEEK_SET );
-    memset( read_buffer, 0, EGZ_READ_BUFFER_LENGTH );
-    memset( symbol_buffer, 0, sizeof( uint64_t ) );
-    memset( write_buffer, 0, EGZ_WRITE_BUFFER_LENGTH );
     fwrite( EGZ_FILE_DATA_ID, sizeof( uint8_t ), strlen( EGZ_FILE_DATA_ID ), destination );
-
     
-    while( ( length = fread( read_buffer, sizeof( unsigned char ), EGZ_READ_BUFFER_LENGTH, source ) ) )
+    /* Each block is compressed independently, with its own table or the shared one */
+    while( status == EGZ_OK )
     {
-        DEBUG( "Getting data from source file" );
-        
-        i        = 0;
-        read_op += 1;
-        
-        write_compressed_file_process_symbols:
-        
-        for( ; i < length; i++ )
+        /* Gives the next blocks to the workers */
+        while( eof == false && NULL != ( job = egz_pool_acquire( pool ) ) )
         {
-            if( num_bits >= EGZ_BTREE_CODE_MAX_LENGTH )
+            /* Mapped file - The workers read the mapping directly */
+            if( mapping != NULL )
             {
-                break;
+                job->data   = mapping->data + position;
+                job->length = ( mapping->length - position < options->block_size ) ? mapping->length - position : options->block_size;
+                
+                /* Adaptive blocks - The block ends where the statistics shift */
+                if( options->adaptive == true )
+                {
+                    job->length = egz_split_block( job->data, mapping->length - position, options->block_size );
+                }
+                
+                position += job->length;
             }
-            
-            c = read_buffer[ i ];
-            s = &( table->symbols[ ( int )c ] );
-            
-            if( EGZ_BTREE_CODE_MAX_LENGTH - num_bits > s->bits  )
+            else if( egz_block_reserve( &( job->input ), options->block_size ) == true )
             {
-                *( data ) |= s->code << ( ( EGZ_BTREE_CODE_MAX_LENGTH - num_bits ) - s->bits );
+                /* The data left after the previous split comes first (no carry buffer without --adaptive) */
+                if( carry.length > 0 )
+                {
+                    memcpy( job->input.data, carry.data, carry.length );
+                }
+                
+                job->data    = job->input.data;
+                job->length  = carry.length + fread( job->input.data + carry.length, sizeof( unsigned char ), options->block_size - carry.length, source );
+                carry.length = 0;
+                
+                if( options->adaptive == true && job->length > 0 )
+                {
+                    length       = egz_split_block( job->data, job->length, options->block_size );
+                    carry.length = job->length - length;
+                    job->length  = length;
+                    
+                    memcpy( carry.data, job->data + length, carry.length );
+                }
             }
             else
             {
-                *( data ) |= s->code >> ( s->bits - ( EGZ_BTREE_CODE_MAX_LENGTH - num_bits ) );
+                status = EGZ_ERROR_MALLOC;
+                break;
             }
             
-            DEBUG
-            (
-                "    - Processing symbol 0x%02X (%c) | Bits: %02u | Left shift: %03i | Buffer: %lu",
-                ( unsigned int )c,
-                ( isprint( c ) && c != 0x20 ) ? c : '.',
-                s->bits,
-                ( EGZ_BTREE_CODE_MAX_LENGTH - num_bits ) - s->bits,
-                *( data )
-             );
-            
-            num_bits += s->bits;
-        }
-        
-        if( num_bits >= EGZ_BTREE_CODE_MAX_LENGTH )
-        {
-            num_bits          = num_bits - EGZ_BTREE_CODE_MAX_LENGTH;
-            write_buffer[ j ] = *( data );
-            
-            j++;
-            
-            DEBUG
-            (
-                "Storing data (%lu) to the buffer %i (bits left: %u)",
-                *( data ),
-                j,
-                num_bits
-            );
-            
-            if( j == EGZ_WRITE_BUFFER_LENGTH / ( EGZ_BTREE_CODE_MAX_LENGTH / 8 ) )
+            if( job->length == 0 )
             {
-                DEBUG( "Writing data to the destination file" );
-                fwrite( write_buffer, sizeof( uint64_t ), j + 1, destination );
-                memset( write_buffer, 0, EGZ_WRITE_BUFFER_LENGTH );
-                
-                j = 0;
+                eof = true;
+                break;
             }
             
-            if( num_bits > 0 )
-            {
-                *( data ) = s->code << ( EGZ_BTREE_CODE_MAX_LENGTH - num_bits );
-                DEBUG( "Symbol buffer value: %lu (%u bits)", *( data ), num_bits );
-            }
-            else
+            /* The size and checksum of a stream are computed as it is read */
+            if( digest != NULL )
             {
-                *( data ) = 0;
+                egz_digest_update( digest, job->data, job->length );
             }
             
+            egz_pool_submit( pool, job );
         }
         
-        if( i < length )
+        /* Blocks are written in the file order, whatever the thread that compressed them */
+        if( status != EGZ_OK || NULL == ( job = egz_pool_collect( pool ) ) )
         {
-            goto write_compressed_file_process_symbols;
+            break;
         }
         
-        if( read_ops > 1 )
-        {
-            __percent = ( ( double )read_op / ( double )read_ops ) * 100;
-        }
-    }
-    
-    if( num_bits > 0 || j > 0 )
-    {
-        DEBUG( "Writing remaining data to the destination file" );
+        read_op += 1;
+        bytes   += job->length;
+        status   = job->status;
         
-        if( num_bits < EGZ_BTREE_CODE_MAX_LENGTH )
+        if( status == EGZ_OK )
         {
-            write_buffer[ j ] = *( data );
+            EGZ_TRACE_BLOCK( EGZ_TRACE_BLOCK_COMPRESSED, read_op, job->length, job->output.length );
+            fwrite( job->output.data, sizeof( unsigned char ), job->output.length, destination );
+            
+            written += job->output.length;
         }
-        fwrite( write_buffer, sizeof( uint64_t ), j + 1, destination );
+        
+        egz_pool_release( pool, job );
+        
+        /* Adaptive blocks have different sizes - The progress is based on the bytes */
+        egz_progress_update( bytes );
     }
     
-    __percent = 100;
-    
-    libprogressbar_end();
+    egz_progress_end();
     
     fseek( source, offset, SEEK_SET );
+    egz_pool_destroy( pool );
+    egz_block_free( &carry );
     
-    return EGZ_OK;
+    /* The workers are part of the encoding time - The checksum of a stream is counted apart */
+    egz_stats_end( &timer, EGZ_STATS_ENCODE, bytes, written );
+    
+    return status;
+}
+
+/*!
+ * 
+ */
+static egz_status egz_compress_job( egz_job * job, void * context )
+{
+    egz_block_context * block_context;
+    
+    block_context = ( egz_block_context * )context;
+    
+    return egz_compress_block( job->data, job->length, block_context->table, block_context->options, &( job->output ) );
 }
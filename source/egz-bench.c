@@ -0,0 +1,1058 @@
+/*******************************************************************************
+ * Copyright (c) 2010, Jean-David Gadina - www.xs-labs.com
+ * Distributed under the Boost Software License, Version 1.0.
+ * 
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ * 
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ * 
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ******************************************************************************/
+
+/* $Id$ */
+
+/*!
+ * @file        egz-bench.c
+ * @copyright   (c) 2011 - Jean-David Gadina - www.xs-labs.com
+ * @abstract    End-to-end throughput benchmark
+ * @description Runs the egz executable (and gzip/zstd, when available) on a
+ *              generated corpus, and writes the throughput, ratio and peak
+ *              memory usage of each run as JSON. With --check-batch, the
+ *              round trip of the batch API is checked on the corpus instead.
+ */
+
+/* wait4() is a BSD extension */
+#ifndef _DEFAULT_SOURCE
+#define _DEFAULT_SOURCE
+#endif
+
+/* Local includes */
+#include "eos-skl/eos-skl.h"
+#include "egz.h"
+
+/* System includes */
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <time.h>
+
+/* Default values for the command line options */
+#define BENCH_DEFAULT_EGZ       "./build/bin/egz"
+#define BENCH_DEFAULT_CORPUS    "./build/tmp/bench"
+#define BENCH_DEFAULT_MAX_SIZE  64
+#define BENCH_DEFAULT_RUNS      3
+
+/* Maximum number of files in the corpus */
+#define BENCH_MAX_FILES         64
+
+/* Size of the buffers used to generate and compare the files */
+#define BENCH_BUFFER_LENGTH     65536
+
+/* Number of bytes in a mebibyte */
+#define BENCH_MIB               ( ( uint64_t )1024 * 1024 )
+
+/* Bytes of each file, and maximum number of messages, used by the batch check */
+#define BENCH_BATCH_LENGTH      ( 1024 * 1024 )
+#define BENCH_BATCH_MESSAGES    1024
+
+/*!
+ * 
+ */
+typedef struct _bench_file
+{
+    char         path[ FILENAME_MAX ];
+    const char * kind;
+    uint64_t     size;
+}
+bench_file;
+
+/*!
+ * 
+ */
+typedef struct _bench_mode
+{
+    const char * tool;
+    const char * name;
+    const char * compress[ 8 ];
+    const char * expand[ 8 ];
+    const char * extension;
+    bool         stdio;
+}
+bench_mode;
+
+/*!
+ * 
+ */
+typedef struct _bench_run
+{
+    double   seconds;
+    long     rss;
+    bool     success;
+}
+bench_run;
+
+/* Private functions */
+static void     bench_print_usage( const char * name );
+static bool     bench_find_program( const char * name );
+static bool     bench_generate_file( bench_file * file, const char * directory, const char * kind, uint64_t size );
+static void     bench_fill( unsigned char * buffer, size_t length, const char * kind, uint64_t * state, uint64_t offset );
+static uint64_t bench_random( uint64_t * state );
+static uint64_t bench_get_size( const char * path );
+static bool     bench_compare_files( const char * path1, const char * path2 );
+static void     bench_spawn( const char ** argv, const char * directory, const char * input, const char * output, bench_run * run );
+static void     bench_measure( const char ** argv, const char * directory, const char * input, const char * output, const char * created, unsigned int runs, bench_run * run );
+static void     bench_write_string( FILE * output, const char * string );
+static bool     bench_check_batch( bench_file * file );
+
+/* Kinds of generated files */
+static const char * bench_kinds[] = { "text", "binary", "low-entropy", "high-entropy" };
+
+/* Sizes of the generated files, in KiB */
+static const uint64_t bench_sizes[] = { 1, 64, 1024, 16384, 65536, 1048576, 4194304 };
+
+/* Message lengths of the batch check (empty messages, and one to three bytes length prefixes) */
+static const size_t bench_batch_lengths[] = { 0, 1, 127, 128, 0, 4096, 16383, 16384, 65536 };
+
+/* Words used to generate the text files */
+static const char * bench_words[] =
+{
+    "the", "of", "and", "a", "to", "in", "is", "you", "that", "it",
+    "he", "was", "for", "on", "are", "as", "with", "his", "they", "at",
+    "be", "this", "have", "from", "or", "one", "had", "by", "word", "but",
+    "not", "what", "all", "were", "we", "when", "your", "can", "said", "there",
+    "compression", "huffman", "symbol", "frequency", "entropy", "block", "stream", "table"
+};
+
+/*!
+ * @abstract        main
+ * @description     Benchmark's entry point
+ * @param           argc    The number of command line arguments
+ * @param           argv    An array with the command line arguments
+ * @result          The process exit status
+ */
+int main( int argc, char * argv[] )
+{
+    int            i;
+    unsigned int   j;
+    unsigned int   k;
+    unsigned int   file_count;
+    unsigned int   mode_count;
+    unsigned int   runs;
+    unsigned int   result_count;
+    uint64_t       max_size;
+    const char   * egz;
+    const char   * corpus;
+    const char   * output_path;
+    FILE         * output;
+    bench_file     files[ BENCH_MAX_FILES ];
+    bench_mode     modes[ 6 ];
+    bench_mode   * mode;
+    bench_run      compress;
+    bench_run      expand;
+    const char   * compress_argv[ 16 ];
+    const char   * expand_argv[ 16 ];
+    char           compressed_path[ FILENAME_MAX ];
+    char           expanded_path[ FILENAME_MAX ];
+    char           egz_path[ FILENAME_MAX ];
+    char           corpus_path[ FILENAME_MAX ];
+    const char   * basename;
+    uint64_t       compressed_size;
+    bool           verified;
+    bool           check_batch;
+    unsigned int   failures;
+    
+    egz         = BENCH_DEFAULT_EGZ;
+    corpus      = BENCH_DEFAULT_CORPUS;
+    output_path = NULL;
+    max_size    = BENCH_DEFAULT_MAX_SIZE;
+    runs        = BENCH_DEFAULT_RUNS;
+    file_count  = 0;
+    check_batch = false;
+    
+    /* Processes the command line arguments (the remaining ones are collected into the corpus) */
+    for( i = 1; i < argc; i++ )
+    {
+        if( strcmp( argv[ i ], "--help" ) == 0 || strcmp( argv[ i ], "-h" ) == 0 )
+        {
+            bench_print_usage( argv[ 0 ] );
+            return EXIT_SUCCESS;
+        }
+        else if( strcmp( argv[ i ], "--egz" ) == 0 && i + 1 < argc )
+        {
+            egz = argv[ ++i ];
+        }
+        else if( strcmp( argv[ i ], "--corpus" ) == 0 && i + 1 < argc )
+        {
+            corpus = argv[ ++i ];
+        }
+        else if( strcmp( argv[ i ], "--max-size" ) == 0 && i + 1 < argc )
+        {
+            max_size = strtoull( argv[ ++i ], NULL, 10 );
+        }
+        else if( strcmp( argv[ i ], "--runs" ) == 0 && i + 1 < argc )
+        {
+            runs = ( unsigned int )strtoul( argv[ ++i ], NULL, 10 );
+        }
+        else if( ( strcmp( argv[ i ], "--output" ) == 0 || strcmp( argv[ i ], "-o" ) == 0 ) && i + 1 < argc )
+        {
+            output_path = argv[ ++i ];
+        }
+        else if( strcmp( argv[ i ], "--check-batch" ) == 0 )
+        {
+            check_batch = true;
+        }
+        else if( argv[ i ][ 0 ] == '-' )
+        {
+            fprintf( stderr, "Error: unknown option %s\n", argv[ i ] );
+            bench_print_usage( argv[ 0 ] );
+            return EXIT_FAILURE;
+        }
+        else if( file_count < BENCH_MAX_FILES )
+        {
+            files[ file_count ].kind = "collected";
+            files[ file_count ].size = bench_get_size( argv[ i ] );
+            
+            if( files[ file_count ].size == 0 || NULL == realpath( argv[ i ], files[ file_count ].path ) )
+            {
+                fprintf( stderr, "Warning: skipping %s (empty or unreadable)\n", argv[ i ] );
+                continue;
+            }
+            
+            file_count++;
+        }
+    }
+    
+    if( runs == 0 )
+    {
+        runs = 1;
+    }
+    
+    if( check_batch == false && ( access( egz, X_OK ) != 0 || NULL == realpath( egz, egz_path ) ) )
+    {
+        fprintf( stderr, "Error: cannot execute %s (build it first, or use --egz)\n", egz );
+        return EXIT_FAILURE;
+    }
+    
+    /* Every run happens in the corpus directory, as egz writes its output files in the current directory */
+    mkdir( corpus, 0755 );
+    
+    if( NULL == realpath( corpus, corpus_path ) )
+    {
+        fprintf( stderr, "Error: cannot create the corpus directory %s\n", corpus );
+        return EXIT_FAILURE;
+    }
+    
+    /* Generates the corpus, reusing the files of a previous run */    
+    for( j = 0; j < sizeof( bench_kinds ) / sizeof( bench_kinds[ 0 ] ); j++ )
+    {
+        for( k = 0; k < sizeof( bench_sizes ) / sizeof( bench_sizes[ 0 ] ); k++ )
+        {
+            if( bench_sizes[ k ] * 1024 > max_size * BENCH_MIB || file_count == BENCH_MAX_FILES )
+            {
+                break;
+            }
+            
+            if( bench_generate_file( &( files[ file_count ] ), corpus_path, bench_kinds[ j ], bench_sizes[ k ] * 1024 ) == false )
+            {
+                fprintf( stderr, "Error: cannot generate the corpus in %s\n", corpus );
+                return EXIT_FAILURE;
+            }
+            
+            file_count++;
+        }
+    }
+    
+    /* Round trip of the batch API, in process (the egz executable is not run) */
+    if( check_batch == true )
+    {
+        failures = 0;
+        
+        for( j = 0; j < file_count; j++ )
+        {
+            if( bench_check_batch( &( files[ j ] ) ) == false )
+            {
+                failures++;
+            }
+        }
+        
+        return ( failures == 0 ) ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    
+    /* The egz modes, and the reference tools that are installed */
+    memset( modes, 0, sizeof( modes ) );
+    
+    mode_count = 0;
+    
+    modes[ mode_count ].tool         = "egz";
+    modes[ mode_count ].name         = "default";
+    modes[ mode_count ].compress[ 0 ] = "-c";
+    modes[ mode_count ].expand[ 0 ]   = "-x";
+    modes[ mode_count ].extension    = ".egz";
+    mode_count++;
+    
+    modes[ mode_count ].tool         = "egz";
+    modes[ mode_count ].name         = "threads";
+    modes[ mode_count ].compress[ 0 ] = "-T";
+    modes[ mode_count ].compress[ 1 ] = "0";
+    modes[ mode_count ].compress[ 2 ] = "-c";
+    modes[ mode_count ].expand[ 0 ]   = "-T";
+    modes[ mode_count ].expand[ 1 ]   = "0";
+    modes[ mode_count ].expand[ 2 ]   = "-x";
+    modes[ mode_count ].extension    = ".egz";
+    mode_count++;
+    
+    modes[ mode_count ].tool         = "egz";
+    modes[ mode_count ].name         = "adaptive";
+    modes[ mode_count ].compress[ 0 ] = "--adaptive";
+    modes[ mode_count ].compress[ 1 ] = "-c";
+    modes[ mode_count ].expand[ 0 ]   = "-x";
+    modes[ mode_count ].extension    = ".egz";
+    mode_count++;
+    
+    modes[ mode_count ].tool         = "egz";
+    modes[ mode_count ].name         = "stdio";
+    modes[ mode_count ].compress[ 0 ] = "-c";
+    modes[ mode_count ].compress[ 1 ] = EGZ_STDIO_NAME;
+    modes[ mode_count ].expand[ 0 ]   = "-x";
+    modes[ mode_count ].expand[ 1 ]   = EGZ_STDIO_NAME;
+    modes[ mode_count ].extension    = ".egz";
+    modes[ mode_count ].stdio        = true;
+    mode_count++;
+    
+    if( bench_find_program( "gzip" ) == true )
+    {
+        modes[ mode_count ].tool         = "gzip";
+        modes[ mode_count ].name         = "reference";
+        modes[ mode_count ].compress[ 0 ] = "-c";
+        modes[ mode_count ].expand[ 0 ]   = "-dc";
+        modes[ mode_count ].extension    = ".gz";
+        mode_count++;
+    }
+    
+    if( bench_find_program( "zstd" ) == true )
+    {
+        modes[ mode_count ].tool         = "zstd";
+        modes[ mode_count ].name         = "reference";
+        modes[ mode_count ].compress[ 0 ] = "-qc";
+        modes[ mode_count ].expand[ 0 ]   = "-qdc";
+        modes[ mode_count ].extension    = ".zst";
+        mode_count++;
+    }
+    
+    if( output_path == NULL )
+    {
+        output = stdout;
+    }
+    else if( NULL == ( output = fopen( output_path, "wb" ) ) )
+    {
+        fprintf( stderr, "Error: cannot open %s for writing\n", output_path );
+        return EXIT_FAILURE;
+    }
+    
+    fprintf( output, "{\n    \"version\": " );
+    bench_write_string( output, EGZ_VERSION );
+    fprintf( output, ",\n    \"egz\": " );
+    bench_write_string( output, egz_path );
+    fprintf( output, ",\n    \"runs\": %u,\n    \"results\":\n    [", runs );
+    
+    result_count = 0;
+    
+    for( j = 0; j < file_count; j++ )
+    {
+        for( k = 0; k < mode_count; k++ )
+        {
+            mode     = &( modes[ k ] );
+            basename = ( NULL == strrchr( files[ j ].path, '/' ) ) ? files[ j ].path : strrchr( files[ j ].path, '/' ) + 1;
+            
+            if
+            (
+                   snprintf( compressed_path, FILENAME_MAX, "%s/%s%s", corpus_path, basename, mode->extension ) >= FILENAME_MAX
+                || snprintf( expanded_path,   FILENAME_MAX, "%s/%s.out", corpus_path, basename )               >= FILENAME_MAX
+            )
+            {
+                fprintf( stderr, "Warning: skipping %s (path too long)\n", files[ j ].path );
+                continue;
+            }
+            
+            
+            fprintf( stderr, "%s (%s): %s\n", mode->tool, mode->name, files[ j ].path );
+            
+            /*
+             * egz writes its output file in the current directory (except in
+             * the stdio mode), while the reference tools always use the
+             * standard output
+             */
+            i = 0;
+            
+            compress_argv[ i++ ] = ( strcmp( mode->tool, "egz" ) == 0 ) ? egz_path : mode->tool;
+            
+            while( i < 9 && mode->compress[ i - 1 ] != NULL )
+            {
+                compress_argv[ i ] = mode->compress[ i - 1 ];
+                i++;
+            }
+            
+            if( mode->stdio == false )
+            {
+                compress_argv[ i++ ] = files[ j ].path;
+            }
+            
+            compress_argv[ i ] = NULL;
+            
+            i = 0;
+            
+            expand_argv[ i++ ] = compress_argv[ 0 ];
+            
+            while( i < 9 && mode->expand[ i - 1 ] != NULL )
+            {
+                expand_argv[ i ] = mode->expand[ i - 1 ];
+                i++;
+            }
+            
+            if( mode->stdio == false )
+            {
+                if( strcmp( mode->tool, "egz" ) == 0 )
+                {
+                    expand_argv[ i++ ] = "-s";
+                }
+                
+                expand_argv[ i++ ] = compressed_path;
+            }
+            
+            expand_argv[ i ] = NULL;
+            
+            remove( compressed_path );
+            
+            if( strcmp( mode->tool, "egz" ) == 0 && mode->stdio == false )
+            {
+                bench_measure( compress_argv, corpus_path, NULL, "/dev/null", compressed_path, runs, &compress );
+            }
+            else
+            {
+                bench_measure( compress_argv, corpus_path, ( mode->stdio == true ) ? files[ j ].path : NULL, compressed_path, NULL, runs, &compress );
+            }
+            
+            compressed_size = bench_get_size( compressed_path );
+            
+            if( compress.success == true && compressed_size > 0 )
+            {
+                bench_measure( expand_argv, corpus_path, ( mode->stdio == true ) ? compressed_path : NULL, expanded_path, NULL, runs, &expand );
+            }
+            else
+            {
+                memset( &expand, 0, sizeof( bench_run ) );
+            }
+            
+            verified = ( expand.success == true && bench_compare_files( files[ j ].path, expanded_path ) == true );
+            
+            remove( compressed_path );
+            remove( expanded_path );
+            
+            fprintf( output, "%s\n        {\n            \"file\": ", ( result_count > 0 ) ? "," : "" );
+            bench_write_string( output, files[ j ].path );
+            fprintf( output, ",\n            \"kind\": " );
+            bench_write_string( output, files[ j ].kind );
+            fprintf( output, ",\n            \"tool\": " );
+            bench_write_string( output, mode->tool );
+            fprintf( output, ",\n            \"mode\": " );
+            bench_write_string( output, mode->name );
+            fprintf
+            (
+                output,
+                ",\n"
+                "            \"size\": %llu,\n"
+                "            \"compressed_size\": %llu,\n"
+                "            \"ratio\": %.4f,\n"
+                "            \"compress_mbps\": %.2f,\n"
+                "            \"expand_mbps\": %.2f,\n"
+                "            \"compress_peak_rss_kib\": %li,\n"
+                "            \"expand_peak_rss_kib\": %li,\n"
+                "            \"verified\": %s\n"
+                "        }",
+                ( unsigned long long )files[ j ].size,
+                ( unsigned long long )compressed_size,
+                ( double )compressed_size / ( double )files[ j ].size,
+                ( compress.seconds > 0 ) ? ( ( double )files[ j ].size / 1000 / 1000 ) / compress.seconds : 0,
+                ( expand.seconds   > 0 ) ? ( ( double )files[ j ].size / 1000 / 1000 ) / expand.seconds   : 0,
+                compress.rss,
+                expand.rss,
+                ( verified == true ) ? "true" : "false"
+            );
+            
+            fflush( output );
+            
+            result_count++;
+        }
+    }
+    
+    fprintf( output, "\n    ]\n}\n" );
+    
+    if( output != stdout )
+    {
+        fclose( output );
+    }
+    
+    return EXIT_SUCCESS;
+}
+
+/*!
+ * 
+ */
+static void bench_print_usage( const char * name )
+{
+    printf
+    (
+        "Usage: %s [OPTIONS] [FILE...]\n"
+        "\n"
+        "Generates a corpus of text, binary, low-entropy and high-entropy files\n"
+        "from 1 KiB up to the maximum size, adds the given files to it, and\n"
+        "measures the compression and expansion of each file with egz (and\n"
+        "gzip/zstd, when installed). The results are written as JSON.\n"
+        "\n"
+        "Options:\n"
+        "    --egz PATH       The egz executable (default: %s)\n"
+        "    --corpus DIR     Where to generate the corpus (default: %s)\n"
+        "    --max-size MIB   Size of the biggest generated files, in MiB (default: %u)\n"
+        "    --runs N         Keeps the fastest of N runs (default: %u)\n"
+        "    -o, --output     Writes the JSON results to a file instead of the standard output\n"
+        "    --check-batch    Only checks the round trip of the batch API on the corpus\n"
+        "    -h, --help       Displays this help\n",
+        name,
+        BENCH_DEFAULT_EGZ,
+        BENCH_DEFAULT_CORPUS,
+        BENCH_DEFAULT_MAX_SIZE,
+        BENCH_DEFAULT_RUNS
+    );
+}
+
+/*!
+ * 
+ */
+static bool bench_find_program( const char * name )
+{
+    const char * path;
+    const char * end;
+    char         filename[ FILENAME_MAX ];
+    size_t       length;
+    
+    if( NULL == ( path = getenv( "PATH" ) ) )
+    {
+        return false;
+    }
+    
+    while( *( path ) != 0 )
+    {
+        if( NULL == ( end = strchr( path, ':' ) ) )
+        {
+            end = path + strlen( path );
+        }
+        
+        length = ( size_t )( end - path );
+        
+        if( length > 0 && length + strlen( name ) + 2 < FILENAME_MAX )
+        {
+            memcpy( filename, path, length );
+            
+            filename[ length ] = '/';
+            
+            strcpy( filename + length + 1, name );
+            
+            if( access( filename, X_OK ) == 0 )
+            {
+                return true;
+            }
+        }
+        
+        path = ( *( end ) == ':' ) ? end + 1 : end;
+    }
+    
+    return false;
+}
+
+/*!
+ * 
+ */
+static bool bench_generate_file( bench_file * file, const char * directory, const char * kind, uint64_t size )
+{
+    FILE          * fp;
+    unsigned char * buffer;
+    uint64_t        state;
+    uint64_t        offset;
+    size_t          length;
+    
+    if( snprintf( file->path, FILENAME_MAX, "%s/%s-%llu.bin", directory, kind, ( unsigned long long )( size / 1024 ) ) >= FILENAME_MAX )
+    {
+        return false;
+    }
+    
+    file->kind = kind;
+    file->size = size;
+    
+    /* Same kind and size means same content, so a previous corpus can be reused */
+    if( bench_get_size( file->path ) == size )
+    {
+        return true;
+    }
+    
+    if( NULL == ( buffer = malloc( BENCH_BUFFER_LENGTH ) ) )
+    {
+        return false;
+    }
+    
+    if( NULL == ( fp = fopen( file->path, "wb" ) ) )
+    {
+        free( buffer );
+        return false;
+    }
+    
+    fprintf( stderr, "Generating %s\n", file->path );
+    
+    state  = 0x9E3779B97F4A7C15ULL ^ size;
+    offset = 0;
+    
+    while( offset < size )
+    {
+        length = ( size - offset < BENCH_BUFFER_LENGTH ) ? ( size_t )( size - offset ) : BENCH_BUFFER_LENGTH;
+        
+        bench_fill( buffer, length, kind, &state, offset );
+        
+        if( fwrite( buffer, 1, length, fp ) != length )
+        {
+            fclose( fp );
+            free( buffer );
+            remove( file->path );
+            return false;
+        }
+        
+        offset += length;
+    }
+    
+    fclose( fp );
+    free( buffer );
+    
+    return true;
+}
+
+/*!
+ * 
+ */
+static void bench_fill( unsigned char * buffer, size_t length, const char * kind, uint64_t * state, uint64_t offset )
+{
+    size_t       i;
+    size_t       j;
+    uint64_t     value;
+    const char * word;
+    
+    if( strcmp( kind, "text" ) == 0 )
+    {
+        /* Words with a skewed distribution, split into lines */
+        i = 0;
+        
+        while( i < length )
+        {
+            value = bench_random( state );
+            word  = bench_words[ ( ( value & 0xFFFF ) * ( ( value >> 16 ) & 0xFFFF ) >> 16 ) % ( sizeof( bench_words ) / sizeof( bench_words[ 0 ] ) ) ];
+            
+            for( j = 0; word[ j ] != 0 && i < length; j++ )
+            {
+                buffer[ i++ ] = ( unsigned char )word[ j ];
+            }
+            
+            if( i < length )
+            {
+                buffer[ i++ ] = ( ( value >> 32 ) % 12 == 0 ) ? '\n' : ( ( ( value >> 40 ) % 9 == 0 ) ? ',' : ' ' );
+            }
+        }
+    }
+    else if( strcmp( kind, "binary" ) == 0 )
+    {
+        /* Records with a counter, a small value, flags and a payload byte */
+        for( i = 0; i < length; i++ )
+        {
+            switch( ( offset + i ) % 16 )
+            {
+                case 0:  buffer[ i ] = ( unsigned char )( ( offset + i ) >> 4 ); break;
+                case 1:  buffer[ i ] = ( unsigned char )( ( offset + i ) >> 12 ); break;
+                case 2:  buffer[ i ] = ( unsigned char )( ( offset + i ) >> 20 ); break;
+                case 4:  buffer[ i ] = ( unsigned char )( bench_random( state ) & 0x0F ); break;
+                case 8:  buffer[ i ] = ( unsigned char )( ( bench_random( state ) & 0x07 ) == 0 ? 0x80 : 0x01 ); break;
+                case 12: buffer[ i ] = ( unsigned char )bench_random( state ); break;
+                default: buffer[ i ] = 0; break;
+            }
+        }
+    }
+    else if( strcmp( kind, "low-entropy" ) == 0 )
+    {
+        /* A few symbols, with geometrically decreasing frequencies */
+        for( i = 0; i < length; i++ )
+        {
+            value = bench_random( state );
+            
+            for( j = 0; j < 7 && ( value & 1 ) == 1; j++ )
+            {
+                value >>= 1;
+            }
+            
+            buffer[ i ] = ( unsigned char )( 'a' + j );
+        }
+    }
+    else
+    {
+        /* Uniformly distributed bytes */
+        for( i = 0; i < length; i++ )
+        {
+            buffer[ i ] = ( unsigned char )( bench_random( state ) >> 56 );
+        }
+    }
+}
+
+/*!
+ * 
+ */
+static uint64_t bench_random( uint64_t * state )
+{
+    uint64_t x;
+    
+    /* xorshift64* - deterministic, so every run uses the same corpus */
+    x        = *( state );
+    x       ^= x >> 12;
+    x       ^= x << 25;
+    x       ^= x >> 27;
+    *( state ) = x;
+    
+    return x * 0x2545F4914F6CDD1DULL;
+}
+
+/*!
+ * 
+ */
+static uint64_t bench_get_size( const char * path )
+{
+    struct stat info;
+    
+    if( stat( path, &info ) != 0 || S_ISREG( info.st_mode ) == 0 )
+    {
+        return 0;
+    }
+    
+    return ( uint64_t )info.st_size;
+}
+
+/*!
+ * 
+ */
+static bool bench_compare_files( const char * path1, const char * path2 )
+{
+    FILE          * fp1;
+    FILE          * fp2;
+    unsigned char * buffer1;
+    unsigned char * buffer2;
+    size_t          length1;
+    size_t          length2;
+    bool            equal;
+    
+    fp1     = fopen( path1, "rb" );
+    fp2     = fopen( path2, "rb" );
+    buffer1 = malloc( BENCH_BUFFER_LENGTH );
+    buffer2 = malloc( BENCH_BUFFER_LENGTH );
+    equal   = ( fp1 != NULL && fp2 != NULL && buffer1 != NULL && buffer2 != NULL );
+    
+    while( equal == true )
+    {
+        length1 = fread( buffer1, 1, BENCH_BUFFER_LENGTH, fp1 );
+        length2 = fread( buffer2, 1, BENCH_BUFFER_LENGTH, fp2 );
+        equal   = ( length1 == length2 && memcmp( buffer1, buffer2, length1 ) == 0 );
+        
+        if( length1 < BENCH_BUFFER_LENGTH )
+        {
+            break;
+        }
+    }
+    
+    if( fp1 != NULL )
+    {
+        fclose( fp1 );
+    }
+    
+    if( fp2 != NULL )
+    {
+        fclose( fp2 );
+    }
+    
+    free( buffer1 );
+    free( buffer2 );
+    
+    return equal;
+}
+
+/*!
+ * 
+ */
+static void bench_spawn( const char ** argv, const char * directory, const char * input, const char * output, bench_run * run )
+{
+    pid_t           pid;
+    int             fd;
+    int             status;
+    struct rusage   usage;
+    struct timespec start;
+    struct timespec end;
+    
+    run->seconds = 0;
+    run->rss     = 0;
+    run->success = false;
+    
+    clock_gettime( CLOCK_MONOTONIC, &start );
+    
+    if( ( pid = fork() ) == -1 )
+    {
+        return;
+    }
+    
+    if( pid == 0 )
+    {
+        if( chdir( directory ) == -1 )
+        {
+            _exit( 127 );
+        }
+        
+        fd = ( input == NULL ) ? open( "/dev/null", O_RDONLY ) : open( input, O_RDONLY );
+        
+        if( fd == -1 || dup2( fd, STDIN_FILENO ) == -1 )
+        {
+            _exit( 127 );
+        }
+        
+        close( fd );
+        
+        if( ( fd = open( output, O_WRONLY | O_CREAT | O_TRUNC, 0644 ) ) == -1 || dup2( fd, STDOUT_FILENO ) == -1 )
+        {
+            _exit( 127 );
+        }
+        
+        close( fd );
+        execvp( argv[ 0 ], ( char * const * )argv );
+        _exit( 127 );
+    }
+    
+    if( wait4( pid, &status, 0, &usage ) == -1 )
+    {
+        return;
+    }
+    
+    clock_gettime( CLOCK_MONOTONIC, &end );
+    
+    run->seconds = ( double )( end.tv_sec - start.tv_sec ) + ( double )( end.tv_nsec - start.tv_nsec ) / 1000000000.0;
+    
+    /* The maximum resident set size is in bytes on Mac OS X, and in KiB on Linux */
+    #ifdef __APPLE__
+    run->rss     = usage.ru_maxrss / 1024;
+    #else
+    run->rss     = usage.ru_maxrss;
+    #endif
+    
+    run->success = ( WIFEXITED( status ) && WEXITSTATUS( status ) == 0 );
+}
+
+/*!
+ * 
+ */
+static void bench_measure( const char ** argv, const char * directory, const char * input, const char * output, const char * created, unsigned int runs, bench_run * run )
+{
+    unsigned int i;
+    bench_run    current;
+    
+    memset( run, 0, sizeof( bench_run ) );
+    
+    /* Keeps the fastest run, and the highest peak memory usage */
+    for( i = 0; i < runs; i++ )
+    {
+        /* egz never overwrites an existing file, so its previous output is removed */
+        if( created != NULL )
+        {
+            remove( created );
+        }
+        
+        bench_spawn( argv, directory, input, output, &current );
+        
+        if( current.success == false )
+        {
+            run->success = false;
+            return;
+        }
+        
+        if( i == 0 || current.seconds < run->seconds )
+        {
+            run->seconds = current.seconds;
+        }
+        
+        if( current.rss > run->rss )
+        {
+            run->rss = current.rss;
+        }
+        
+        run->success = true;
+    }
+}
+
+/*!
+ * 
+ */
+static void bench_write_string( FILE * output, const char * string )
+{
+    fputc( '"', output );
+    
+    while( *( string ) != 0 )
+    {
+        if( *( string ) == '"' || *( string ) == '\\' )
+        {
+            fputc( '\\', output );
+            fputc( *( string ), output );
+        }
+        else if( ( unsigned char )*( string ) < 0x20 )
+        {
+            fprintf( output, "\\u%04x", ( unsigned int )( unsigned char )*( string ) );
+        }
+        else
+        {
+            fputc( *( string ), output );
+        }
+        
+        string++;
+    }
+    
+    fputc( '"', output );
+}
+
+/*!
+ * 
+ */
+static bool bench_check_batch( bench_file * file )
+{
+    FILE          * fp;
+    unsigned char * data;
+    unsigned char * compressed;
+    unsigned char * expanded;
+    unsigned char * messages[ BENCH_BATCH_MESSAGES ];
+    size_t          lengths[ BENCH_BATCH_MESSAGES ];
+    size_t          offsets[ BENCH_BATCH_MESSAGES ];
+    size_t          count;
+    size_t          length;
+    size_t          offset;
+    size_t          capacity;
+    size_t          written;
+    size_t          index;
+    size_t          i;
+    uint64_t        state;
+    egz_context   * context;
+    egz_batch       batch;
+    egz_status      status;
+    bool            success;
+    
+    data       = malloc( BENCH_BATCH_LENGTH );
+    expanded   = malloc( BENCH_BATCH_LENGTH );
+    compressed = NULL;
+    context    = egz_context_create( NULL );
+    length     = 0;
+    success    = false;
+    status     = EGZ_OK;
+    
+    memset( &batch, 0, sizeof( egz_batch ) );
+    
+    if( data != NULL && expanded != NULL && context != NULL && NULL != ( fp = fopen( file->path, "rb" ) ) )
+    {
+        length = fread( data, 1, BENCH_BATCH_LENGTH, fp );
+        
+        fclose( fp );
+    }
+    
+    /* Splits the data into messages, cycling through the lengths (the last message gets the remaining bytes) */
+    for( count = 0, offset = 0; count < BENCH_BATCH_MESSAGES && length > 0; count++ )
+    {
+        lengths[ count ] = bench_batch_lengths[ count % ( sizeof( bench_batch_lengths ) / sizeof( bench_batch_lengths[ 0 ] ) ) ];
+        
+        if( lengths[ count ] > length - offset || count == BENCH_BATCH_MESSAGES - 1 )
+        {
+            lengths[ count ] = length - offset;
+        }
+        
+        messages[ count ] = data + offset;
+        offsets[ count ]  = offset;
+        offset           += lengths[ count ];
+        
+        if( offset == length )
+        {
+            count++;
+            
+            break;
+        }
+    }
+    
+    if( length > 0 )
+    {
+        capacity = egz_compress_batch_bound( context, lengths, count );
+        
+        if( NULL != ( compressed = malloc( capacity ) ) )
+        {
+            status = egz_compress_batch( context, messages, lengths, count, compressed, capacity, &written );
+        }
+        
+        if( compressed != NULL && status == EGZ_OK )
+        {
+            status = egz_batch_open( &batch, compressed, written );
+        }
+        
+        success = ( compressed != NULL && status == EGZ_OK );
+    }
+    
+    /* Decodes the messages backwards, then in a random order, so the batch has to seek back to earlier messages */
+    state = 0x9E3779B97F4A7C15ULL;
+    
+    for( i = 0; success == true && i < count * 2; i++ )
+    {
+        index = ( i < count ) ? count - 1 - i : ( size_t )( bench_random( &state ) % count );
+        
+        if( egz_batch_length( &batch, index, &written ) != EGZ_OK || written != lengths[ index ] )
+        {
+            success = false;
+            
+            break;
+        }
+        
+        status  = egz_batch_expand( &batch, index, expanded, lengths[ index ], &written );
+        success = ( status == EGZ_OK && written == lengths[ index ] && memcmp( expanded, data + offsets[ index ], written ) == 0 );
+    }
+    
+    /* An index past the last message is an error */
+    if( success == true && egz_batch_expand( &batch, count, expanded, BENCH_BATCH_LENGTH, &written ) != EGZ_ERROR_INVALID_INDEX )
+    {
+        success = false;
+    }
+    
+    fprintf( stderr, "batch: %s - %lu messages, %s\n", file->path, ( unsigned long )count, ( success == true ) ? "ok" : "FAILED" );
+    
+    egz_batch_close( &batch );
+    egz_context_destroy( context );
+    free( compressed );
+    free( expanded );
+    free( data );
+    
+    return success;
+}
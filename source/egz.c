@@ -48,11 +48,22 @@
  */
 int main( int argc, char * argv[] )
 {
-    egz_status   status;
-    FILE       * source;
-    FILE       * destination;
-    char         destination_filename[ FILENAME_MAX ];
-    egz_cli_args args;
+    int           fd;
+    unsigned int  i;
+    egz_status    status;
+    FILE        * source;
+    FILE        * destination;
+    FILE        * output;
+    char          destination_filename[ FILENAME_MAX ];
+    egz_cli_args  args;
+    egz_options   options;
+    egz_table   * table;
+    unsigned int  checksum_type;
+    unsigned int  stats_format;
+    int           progress_fd;
+    unsigned long failures;
+    egz_files     files;
+    egz_archive   archive;
     
     /* Processes the command line arguments */
     egz_get_cli_args( argc, argv, &args );
@@ -71,6 +82,40 @@ int main( int argc, char * argv[] )
         return EXIT_SUCCESS;
     }
     
+    /* The standard input is always written to the standard output */
+    if( args.source != NULL && strcmp( args.source, EGZ_STDIO_NAME ) == 0 )
+    {
+        args.to_stdout = true;
+    }
+    
+    /* Only this thread reports the progress */
+    egz_progress_init();
+    
+    progress_fd = -1;
+    
+    /* Checks the progress descriptor - The standard output may carry the data */
+    if( args.progress_fd != NULL && ( egz_get_progress_fd( args.progress_fd, &progress_fd ) == false || ( progress_fd == STDOUT_FILENO && args.to_stdout == true ) ) )
+    {
+        ERROR( "Invalid progress file descriptor: %s", args.progress_fd );
+    }
+    
+    /* Progress goes to the descriptor instead of the terminal - Checked before the standard output is duplicated, so it cannot take the descriptor of the data */
+    if( progress_fd >= 0 && egz_progress_open( progress_fd ) == false )
+    {
+        ERROR( "Progress file descriptor is not open: %d", progress_fd );
+    }
+    
+    output = NULL;
+    
+    /* The data goes to the original standard output, and every message to the standard error */
+    if( args.to_stdout == true )
+    {
+        if( ( fd = dup( STDOUT_FILENO ) ) == -1 || dup2( STDERR_FILENO, STDOUT_FILENO ) == -1 || NULL == ( output = fdopen( fd, "wb" ) ) )
+        {
+            ERROR( "Cannot write to the standard output" );
+        }
+    }
+    
     /* Enables debug if requested */
     if( args.debug == true )
     {
@@ -83,9 +128,26 @@ int main( int argc, char * argv[] )
         "Command line arguments:\n"
         "          - Compress:    %s\n"
         "          - Expand:      %s\n"
+        "          - Force:       %s\n"
         "          - Version:     %s\n"
         "          - Help:        %s\n"
         "          - Debug:       %s\n"
+        "          - Max bits:    %u\n"
+        "          - Streams:     %u\n"
+        "          - Block size:  %u\n"
+        "          - Threads:     %u\n"
+        "          - Stdout:      %s\n"
+        "          - Train:       %s\n"
+        "          - Adaptive:    %s\n"
+        "          - Table:       %s\n"
+        "          - Checksum:    %s\n"
+        "          - Stats:       %s\n"
+        "          - Progress FD: %s\n"
+        "          - Recursive:   %s\n"
+        "          - Files from:  %s\n"
+        "          - Archive:     %s\n"
+        "          - List:        %s\n"
+        "          - Output:      %s\n"
         "          - Source:      %s",
         ( args.compress    == true ) ? "yes"            : "no",
         ( args.expand      == true ) ? "yes"            : "no",
@@ -93,6 +155,22 @@ int main( int argc, char * argv[] )
         ( args.version     == true ) ? "yes"            : "no",
         ( args.help        == true ) ? "yes"            : "no",
         ( args.debug       == true ) ? "yes"            : "no",
+        args.max_code_bits,
+        args.streams,
+        args.block_size,
+        args.threads,
+        ( args.to_stdout   == true ) ? "yes"            : "no",
+        ( args.train       == true ) ? "yes"            : "no",
+        ( args.adaptive    == true ) ? "yes"            : "no",
+        ( args.table       != NULL ) ? args.table       : "N/A",
+        ( args.check       != NULL ) ? args.check       : "N/A",
+        ( args.stats       != NULL ) ? "yes"            : "no",
+        ( args.progress_fd != NULL ) ? args.progress_fd : "N/A",
+        ( args.recursive   == true ) ? "yes"            : "no",
+        ( args.files_from  != NULL ) ? args.files_from  : "N/A",
+        ( args.archive     != NULL ) ? args.archive     : "N/A",
+        ( args.list        == true ) ? "yes"            : "no",
+        ( args.output      != NULL ) ? args.output      : "N/A",
         ( args.source      != NULL ) ? args.source      : "N/A"
     );
     
@@ -105,27 +183,266 @@ int main( int argc, char * argv[] )
     }
     
     /* Checks if a source file was specified */
-    else if( args.source == NULL )
+    else if( args.source == NULL && args.files_from == NULL && ( args.archive == NULL || args.compress == true ) )
     {
         ERROR( "No source file specified" );
     }
     
+    /* Checks the maximum code length */
+    else if( args.max_code_bits < EGZ_MAX_CODE_BITS_MIN || args.max_code_bits > EGZ_BTREE_CODE_MAX_LENGTH )
+    {
+        ERROR( "Invalid maximum code length: %u (must be between %u and %u)", args.max_code_bits, EGZ_MAX_CODE_BITS_MIN, EGZ_BTREE_CODE_MAX_LENGTH );
+    }
+    
+    /* Checks the number of streams */
+    else if( args.streams < 1 || args.streams > EGZ_STREAMS_MAX )
+    {
+        ERROR( "Invalid number of streams: %u (must be between 1 and %u)", args.streams, EGZ_STREAMS_MAX );
+    }
+    
+    /* Checks the number of threads (0 means one per processor) */
+    else if( args.threads > EGZ_THREADS_MAX )
+    {
+        ERROR( "Invalid number of threads: %u (must be between 0 and %u)", args.threads, EGZ_THREADS_MAX );
+    }
+    
+    /* Checks the block size */
+    else if( args.block_size < EGZ_BLOCK_SIZE_MIN || args.block_size > EGZ_BLOCK_SIZE_MAX )
+    {
+        ERROR( "Invalid block size: %u KiB (must be between %u and %u)", args.block_size / 1024, EGZ_BLOCK_SIZE_MIN / 1024, EGZ_BLOCK_SIZE_MAX / 1024 );
+    }
+    
+    checksum_type = EGZ_CHECKSUM_DEFAULT;
+    
+    /* Checks the checksum algorithm */
+    if( args.check != NULL && egz_get_checksum_type( args.check, &checksum_type ) == false )
+    {
+        ERROR( "Invalid checksum algorithm: %s (must be crc32c, xxh64, md5 or none)", args.check );
+    }
+    
+    stats_format = 0;
+    
+    /* Checks the statistics format */
+    if( args.stats != NULL && egz_get_stats_format( args.stats, &stats_format ) == false )
+    {
+        ERROR( "Invalid statistics format: %s (must be text or json)", args.stats );
+    }
+    
+    /* The timing starts here, so the total includes opening the files */
+    if( args.stats != NULL )
+    {
+        egz_stats_enable();
+    }
+    
+    /* Builds a table of codes from the sample files */
+    if( args.train == true )
+    {
+        if( args.output == NULL )
+        {
+            ERROR( "No table file specified (-o)" );
+        }
+        
+        for( i = 0; i < args.source_count; i++ )
+        {
+            if( access( args.sources[ i ], R_OK ) == -1 )
+            {
+                ERROR( "Sample file is not readable: %s", args.sources[ i ] );
+            }
+        }
+        
+        if( NULL == ( table = egz_create_table() ) )
+        {
+            ERROR( "Unable to train the table. Reason: %s.", egz_error_str( EGZ_ERROR_MALLOC ) );
+        }
+        
+        DEBUG( "Training the table with %u sample file(s)", args.source_count );
+        
+        if( EGZ_OK != ( status = egz_train_table( table, args.sources, args.source_count, args.max_code_bits ) ) || EGZ_OK != ( status = egz_save_table( table, args.output ) ) )
+        {
+            free( table );
+            ERROR( "Unable to train the table. Reason: %s.", egz_error_str( status ) );
+        }
+        
+        printf
+        (
+            "Sample files:           %u\n"
+            "Sample size:            %.2f MB\n"
+            "Table ID:               %016llx\n",
+            args.source_count,
+            ( ( double )table->total / ( double )1000 ) / ( double )1000,
+            ( unsigned long long )table->id
+        );
+        
+        free( table );
+        
+        return EXIT_SUCCESS;
+    }
+    
+    options.max_code_bits = args.max_code_bits;
+    options.streams       = args.streams;
+    options.block_size    = args.block_size;
+    options.threads       = ( args.threads > 0 ) ? args.threads : egz_get_processor_count();
+    options.streamed      = args.to_stdout;
+    options.table_file    = args.table;
+    options.adaptive      = args.adaptive;
+    options.quiet         = false;
+    options.checksum_type = checksum_type;
+    
+    /* An archive - The files are members of a single one, with an index at the end */
+    if( args.archive != NULL || args.list == true )
+    {
+        if( args.to_stdout == true )
+        {
+            ERROR( "An archive cannot be written to the standard output" );
+        }
+        
+        failures = 0;
+        
+        /* Only the index is read */
+        if( args.list == true )
+        {
+            if( EGZ_OK != ( status = egz_archive_open( ( args.archive != NULL ) ? args.archive : args.source, &archive ) ) )
+            {
+                ERROR( "Cannot read the archive: %s. Reason: %s.", ( args.archive != NULL ) ? args.archive : args.source, egz_error_str( status ) );
+            }
+            
+            egz_archive_list( &archive );
+            egz_archive_close( &archive );
+            
+            return EXIT_SUCCESS;
+        }
+        else if( args.compress == true )
+        {
+            /* The members are compressed in memory, which needs the symbols of each file */
+            if( args.table != NULL )
+            {
+                ERROR( "A pre-trained table cannot be used to create an archive" );
+            }
+            
+            egz_files_init( &files );
+            
+            for( i = 0; i < args.source_count; i++ )
+            {
+                if( EGZ_OK != ( status = egz_files_add( &files, args.sources[ i ], args.recursive, true ) ) )
+                {
+                    ERROR( "Unable to list the source files. Reason: %s.", egz_error_str( status ) );
+                }
+            }
+            
+            if( args.files_from != NULL && EGZ_OK != ( status = egz_files_read_list( &files, args.files_from, args.recursive, true ) ) )
+            {
+                ERROR( "Cannot read the list of files: %s", args.files_from );
+            }
+            
+            failures = files.errors;
+            
+            if( EGZ_OK != ( status = egz_archive_create( args.archive, &files, &options, options.threads, &failures ) ) )
+            {
+                ERROR( "Unable to create the archive: %s. Reason: %s.", args.archive, egz_error_str( status ) );
+            }
+            
+            egz_files_free( &files );
+        }
+        else if( args.expand == true )
+        {
+            if( EGZ_OK != ( status = egz_archive_open( args.archive, &archive ) ) )
+            {
+                ERROR( "Cannot read the archive: %s. Reason: %s.", args.archive, egz_error_str( status ) );
+            }
+            
+            /* The sources are the names of the members to expand */
+            status = egz_archive_extract( &archive, args.sources, args.source_count, &options, &failures );
+            
+            egz_archive_close( &archive );
+            
+            if( status != EGZ_OK )
+            {
+                ERROR( "Unable to expand the archive: %s. Reason: %s.", args.archive, egz_error_str( status ) );
+            }
+        }
+        else
+        {
+            egz_print_usage( argv[ 0 ] );
+            return EXIT_SUCCESS;
+        }
+        
+        if( args.stats != NULL )
+        {
+            fflush( stdout );
+            egz_stats_print( stderr, stats_format );
+        }
+        
+        return ( failures > 0 ) ? EXIT_FAILURE : EXIT_SUCCESS;
+    }
+    
+    /* Several sources, a directory or a list of files - Each file is processed on its own, by the threads */
+    if( args.source_count > 1 || args.recursive == true || args.files_from != NULL )
+    {
+        /* Nothing to do with the files - Prints the help dialog, as for a single file */
+        if( args.compress == false && args.expand == false )
+        {
+            egz_print_usage( argv[ 0 ] );
+            return EXIT_SUCCESS;
+        }
+        else if( args.to_stdout == true )
+        {
+            ERROR( "Several files cannot be written to the standard output" );
+        }
+        
+        egz_files_init( &files );
+        
+        for( i = 0; i < args.source_count; i++ )
+        {
+            if( EGZ_OK != ( status = egz_files_add( &files, args.sources[ i ], args.recursive, args.compress ) ) )
+            {
+                ERROR( "Unable to list the source files. Reason: %s.", egz_error_str( status ) );
+            }
+        }
+        
+        if( args.files_from != NULL && EGZ_OK != ( status = egz_files_read_list( &files, args.files_from, args.recursive, args.compress ) ) )
+        {
+            ERROR( "Cannot read the list of files: %s", args.files_from );
+        }
+        
+        failures = files.errors;
+        
+        /* The same threads would otherwise also split each file - The files are spread over them instead */
+        if( EGZ_OK != ( status = egz_files_process( &files, &options, args.compress, options.threads, &failures ) ) )
+        {
+            ERROR( "Unable to process the files. Reason: %s.", egz_error_str( status ) );
+        }
+        
+        egz_files_free( &files );
+        
+        if( args.stats != NULL )
+        {
+            fflush( stdout );
+            egz_stats_print( stderr, stats_format );
+        }
+        
+        return ( failures > 0 ) ? EXIT_FAILURE : EXIT_SUCCESS;
+    }
+    
     DEBUG( "Checking the access to the source and destination files" );
     
     /* Checks if the source file exists */
-    if( access( args.source, F_OK ) == -1 )
+    if( strcmp( args.source, EGZ_STDIO_NAME ) != 0 && access( args.source, F_OK ) == -1 )
     {
         ERROR( "Source file does not exist: %s", args.source );
     }
     
     /* Checks if the source file is readable */
-    if( access( args.source, R_OK ) == -1 )
+    if( strcmp( args.source, EGZ_STDIO_NAME ) != 0 && access( args.source, R_OK ) == -1 )
     {
         ERROR( "Source file is not readable: %s", args.source );
     }
     
     /* Gets the file name for the destination file */
-    if( egz_get_destination_filename( args.source, destination_filename, ( args.compress == true ) ? true : false ) == false )
+    if( args.to_stdout == true )
+    {
+        strcpy( destination_filename, "stdout" );
+    }
+    else if( egz_get_destination_filename( args.source, destination_filename, ( args.compress == true ) ? true : false, false ) == false )
     {
         ERROR( "Cannot determine a destination filename" );
     }
@@ -134,13 +451,21 @@ int main( int argc, char * argv[] )
     DEBUG( "Opening the file handles" );
     
     /* Opens a file handle to the source file (read) */
-    if( NULL == ( source = fopen( args.source, "rb" ) ) )
+    if( strcmp( args.source, EGZ_STDIO_NAME ) == 0 )
+    {
+        source = stdin;
+    }
+    else if( NULL == ( source = fopen( args.source, "rb" ) ) )
     {
         ERROR( "Cannot open source file for reading: %s", args.source );
     }
     
     /* Opens a file handle to the destination file (write) */
-    if( NULL == ( destination = fopen( destination_filename, "wb+" ) ) )
+    if( args.to_stdout == true )
+    {
+        destination = output;
+    }
+    else if( NULL == ( destination = fopen( destination_filename, "wb+" ) ) )
     {
         fclose( source );
         ERROR( "Cannot open destination file for writing: %s", destination_filename );
@@ -152,13 +477,20 @@ int main( int argc, char * argv[] )
         DEBUG( "Entering the compress process" );
         
         /* Compress the source file */
-        status = egz_compress( source, destination, args.force );
+        status = egz_compress( source, destination, &options );
         
         /* Checks the return status */
         if( status != EGZ_OK )
         {
-            DEBUG( "Removing destination file" );
-            remove( destination_filename );
+            if( args.to_stdout == false )
+            {
+                DEBUG( "Removing destination file" );
+                remove( destination_filename );
+            }
+            
+            /* The recorded events show what led to the failure (debug builds only) */
+            egz_trace_dump( stderr );
+            
             ERROR( "Unable to compress file %s. Reason: %s.", args.source, egz_error_str( status ) );
         }
     }
@@ -167,13 +499,20 @@ int main( int argc, char * argv[] )
         DEBUG( "Entering the expand process" );
         
         /* Compress the source file */
-        status = egz_expand( source, destination );
+        status = egz_expand( source, destination, &options );
         
         /* Checks the return status */
         if( status != EGZ_OK )
         {
-            DEBUG( "Removing destination file" );
-            remove( destination_filename );
+            if( args.to_stdout == false )
+            {
+                DEBUG( "Removing destination file" );
+                remove( destination_filename );
+            }
+            
+            /* The recorded events show what led to the failure (debug builds only) */
+            egz_trace_dump( stderr );
+            
             ERROR( "Unable to expand file %s. Reason: %s.", args.source, egz_error_str( status ) );
         }
     }
@@ -187,6 +526,20 @@ int main( int argc, char * argv[] )
     DEBUG( "Closing the file handles" );
     fclose( source );
     fclose( destination );
+    
+    /* The statistics go to the standard error, so they never mix with the data or the summary */
+    if( args.stats != NULL )
+    {
+        fflush( stdout );
+        egz_stats_print( stderr, stats_format );
+    }
+    
+    /* Dumps the trace buffer on demand, when the binary was built with a trace level */
+    if( args.debug == true )
+    {
+        egz_trace_dump( stderr );
+    }
+    
     DEBUG( "Terminating the process" );
     
     return EXIT_SUCCESS;
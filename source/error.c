@@ -49,9 +49,13 @@ char * egz_error_str( egz_status code )
         case EGZ_ERROR_MALLOC:              return "out of memory";
         case EGZ_ERROR_EMPTY_FILE:          return "file is empty";
         case EGZ_ERROR_INVALID_FORMAT:      return "file is not an EGZ file";
-        case EGZ_ERROR_INVALID_CHECKSUM:    return "invalid file MD5 checksum";
+        case EGZ_ERROR_INVALID_CHECKSUM:    return "invalid checksum";
         case EGZ_ERROR_ABORT:               return "user abort";
         case EGZ_ERROR_INVALID_TREE:        return "invalid binary tree";
+        case EGZ_ERROR_BUFFER_TOO_SMALL:    return "destination buffer is too small";
+        case EGZ_ERROR_INVALID_INDEX:       return "index out of range";
+        case EGZ_ERROR_TABLE_NOT_FOUND:     return "pre-trained table not found";
+        case EGZ_ERROR_FILE:                return "cannot read or write file";
         default:                            return "unknown error";
     }
 }
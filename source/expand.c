@@ -38,114 +38,199 @@
 /* Local includes */
 #include "egz.h"
 
-/* Private variables */
-static unsigned int __percent = 0;
+/* Private functions */
+static bool egz_read_data_id( FILE * source );
+static egz_status egz_expand_job( egz_job * job, void * context );
 
-egz_status egz_expand( FILE * source, FILE * destination )
+egz_status egz_expand( FILE * source, FILE * destination, egz_options * options )
 {
     long            offset;
+    long            position;
     unsigned int    count;
+    uint8_t         flags;
     uint16_t        header_length;
     uint64_t        bytes;
     unsigned char * header;
-    unsigned char * md5;
+    unsigned char * checksum;
     egz_symbol    * symbols;
     egz_symbol    * tree;
+    egz_lookup    * lookup;
     egz_status      status;
-    char            id[ 4 ]        = { 0, 0, 0, 0 };
-    char            header_id[ 4 ] = { 0, 0, 0, 0 };
+    egz_header      info;
+    egz_digest      digest;
+    egz_timer       timer;
+    unsigned char   lengths[ 256 ];
+    unsigned char   prefix[ EGZ_HEADER_PREFIX_LENGTH ];
     
-    offset = ftell( source );
+    /* The stream starts at the current position, which is not the start of an archive member */
+    offset  = ftell( source );
+    symbols = NULL;
+    tree    = NULL;
+    lookup  = NULL;
     
-    fseek( source, 0, SEEK_SET );
+    egz_stats_begin( &timer );
     
-    DEBUG( "Verifying the file signature" );
-    if( fread( id, sizeof( uint8_t ), 3, source ) != 3 || strcmp( id, EGZ_FILE_ID ) != 0 )
+    DEBUG( "Verifying the file signature and getting the header's length" );
+    if( fread( prefix, sizeof( uint8_t ), EGZ_HEADER_PREFIX_LENGTH, source ) != EGZ_HEADER_PREFIX_LENGTH )
     {
         return EGZ_ERROR_INVALID_FORMAT;
     }
     
-    DEBUG( "Getting the header's length" );
-    if( ( fread( &header_length, sizeof( uint16_t ), 1, source ) != 1 ) )
-    {
-        return EGZ_ERROR_INVALID_FORMAT;
-    }
+    memcpy( &header_length, prefix + strlen( EGZ_FILE_ID ), sizeof( uint16_t ) );
     
-    if( NULL == ( header = ( unsigned char * )malloc( header_length ) ) )
+    if( NULL == ( header = ( unsigned char * )malloc( EGZ_HEADER_PREFIX_LENGTH + header_length ) ) )
     {
         return EGZ_ERROR_MALLOC;
     }
     
-    if( fread( header_id, sizeof( uint8_t ), 3, source ) != 3 || strcmp( header_id, EGZ_FILE_HEADER_ID ) != 0 )
+    DEBUG( "Getting the header data (%hu bytes)", header_length );
+    
+    memcpy( header, prefix, EGZ_HEADER_PREFIX_LENGTH );
+    
+    if( fread( header + EGZ_HEADER_PREFIX_LENGTH, sizeof( uint8_t ), header_length, source ) != header_length )
     {
+        free( header );
         return EGZ_ERROR_INVALID_FORMAT;
     }
     
-    DEBUG( "Getting the header data (%hu bytes)", header_length );
-    
-    if( fread( header, sizeof( uint8_t ), header_length, source ) != header_length )
+    if( egz_read_header( header, EGZ_HEADER_PREFIX_LENGTH + header_length, &info ) != EGZ_OK )
     {
         free( header );
         return EGZ_ERROR_INVALID_FORMAT;
     }
     
-    md5   = ( header + sizeof( uint64_t ) );
-    bytes = ( ( uint64_t )( *( header + 7 ) ) << 56 )
-    | ( ( uint64_t )( *( header + 6 ) ) << 48 )
-    | ( ( uint64_t )( *( header + 5 ) ) << 40 )
-    | ( ( uint64_t )( *( header + 4 ) ) << 32 )
-    | ( ( uint64_t )( *( header + 3 ) ) << 24 )
-    | ( ( uint64_t )( *( header + 2 ) ) << 16 )
-    | ( ( uint64_t )( *( header + 1 ) ) << 8 )
-    |   ( uint64_t )( *( header ) );
+    flags    = info.flags;
+    bytes    = info.original_length;
+    checksum = info.checksum;
+    
+    egz_stats_end( &timer, EGZ_STATS_PARSE, EGZ_HEADER_PREFIX_LENGTH + header_length, 0 );
+    egz_stats_begin( &timer );
     
     DEBUG( "Original file is %lu bytes", bytes );
-    DEBUG( "Original file MD5 checksum: %s", md5 );
+    DEBUG( "Original file %s checksum: %s", egz_get_checksum_name( info.checksum_type ), checksum );
     DEBUG( "Getting symbols informations" );
     
-    count = egz_rebuild_symbols( header + 41, &symbols, header_length - 41 );
-    
-    DEBUG( "Rebuilding the binray tree of symbols" );
-    
-    if( count == 0 )
+    if( info.v1 == true )
     {
-        free( header );
-        return EGZ_ERROR_INVALID_FORMAT;
+        /* Version 1 - Raw codes, the binary tree needs to be rebuilt */
+        count = egz_rebuild_symbols( info.symbols, &symbols, info.symbols_length );
+        
+        DEBUG( "Rebuilding the binray tree of symbols" );
+        
+        if( count == 0 )
+        {
+            free( header );
+            return EGZ_ERROR_INVALID_FORMAT;
+        }
+        else if( count == 0xFFFFFFFF )
+        {
+            free( header );
+            
+            return EGZ_ERROR_MALLOC;
+        }
+        
+        status = egz_rebuild_tree( &tree, symbols, count );
+        
+        if( status != EGZ_OK )
+        {
+            free( symbols );
+            free( header );
+            
+            return status;
+        }
+        
+        DEBUG( "Creating the lookup table" );
+        
+        status = ( NULL == ( lookup = egz_create_lookup( tree ) ) ) ? EGZ_ERROR_MALLOC : EGZ_OK;
     }
-    else if( count == 0xFFFFFFFF )
+    else if( ( flags & EGZ_HEADER_FLAG_TABLE_ID ) != 0 )
     {
-        free( header );
+        /* Pre-trained table - Loaded from the given file or from the search path */
+        DEBUG( "Looking for the pre-trained table %016llx", ( unsigned long long )info.table_id );
         
-        return EGZ_ERROR_MALLOC;
+        status = egz_find_table_lookup( &lookup, info.table_id, options->table_file );
+    }
+    else if( ( flags & EGZ_HEADER_FLAG_STREAMED ) != 0 )
+    {
+        /* Streamed file - Every block has its own table */
+        status = EGZ_OK;
+    }
+    else if( ( flags & EGZ_HEADER_FLAG_BLOCKS ) != 0 && info.symbols_length >= 2 && info.symbols[ 0 ] == 0 && info.symbols[ 1 ] == 0 )
+    {
+        /* Empty shared table - The data was incompressible, every block is stored or has its own table */
+        status = EGZ_OK;
+    }
+    else
+    {
+        /* Canonical codes - Only the code lengths are needed */
+        count = egz_rebuild_lengths( info.symbols, lengths, info.symbols_length );
+        
+        if( count == 0 )
+        {
+            free( header );
+            return EGZ_ERROR_INVALID_FORMAT;
+        }
+        
+        DEBUG( "Creating the lookup table from the canonical code lengths" );
+        
+        status = egz_create_canonical_lookup( &lookup, lengths );
     }
-    
-    status = egz_rebuild_tree( &tree, symbols, count );
     
     if( status != EGZ_OK )
     {
+        free( tree );
         free( symbols );
         free( header );
         
         return status;
     }
     
+    egz_stats_end( &timer, EGZ_STATS_REBUILD, info.symbols_length, 0 );
+    
     DEBUG( "Expanding file" );
     
-    status = egz_write_expanded_file( source, destination, tree, bytes );
+    position = ftell( source );
     
-    if( status != EGZ_OK )
+    if( ( flags & EGZ_HEADER_FLAG_BLOCKS ) != 0 )
     {
-        free( tree );
-        free( header );
-        free( symbols );
+        status = egz_write_expanded_blocks( source, destination, lookup, flags, bytes, checksum, options );
+    }
+    else if( ( flags & EGZ_HEADER_FLAG_STREAMS ) != 0 )
+    {
+        egz_digest_init( &digest, info.checksum_type );
         
-        return status;
+        digest.stage = EGZ_STATS_VERIFY;
+        
+        egz_stats_begin( &timer );
+        
+        /* The output is checked as it is written, so it is not read again */
+        if( EGZ_OK == ( status = egz_write_expanded_streams( source, destination, lookup, bytes, &digest ) ) )
+        {
+            egz_stats_end( &timer, EGZ_STATS_DECODE, ( uint64_t )( ftell( source ) - position ), bytes );
+            
+            status = egz_verify_checksum( &digest, checksum );
+        }
+    }
+    else
+    {
+        egz_digest_init( &digest, info.checksum_type );
+        
+        digest.stage = EGZ_STATS_VERIFY;
+        
+        egz_stats_begin( &timer );
+        
+        /* The output is checked as it is written, so it is not read again */
+        if( EGZ_OK == ( status = egz_write_expanded_file( source, destination, lookup, bytes, &digest ) ) )
+        {
+            egz_stats_end( &timer, EGZ_STATS_DECODE, ( uint64_t )( ftell( source ) - position ), bytes );
+            
+            status = egz_verify_checksum( &digest, checksum );
+        }
     }
-    
-    status = egz_verify_checksum( destination, md5 );
     
     if( status != EGZ_OK )
     {
+        free( lookup );
         free( tree );
         free( header );
         free( symbols );
@@ -153,6 +238,7 @@ egz_status egz_expand( FILE * source, FILE * destination )
         return status;
     }
     
+    free( lookup );
     free( tree );
     free( symbols );
     free( header );
@@ -161,16 +247,140 @@ egz_status egz_expand( FILE * source, FILE * destination )
     return EGZ_OK;
 }
 
+egz_status egz_read_header( unsigned char * data, size_t length, egz_header * header )
+{
+    uint16_t header_length;
+    
+    if( length < EGZ_HEADER_PREFIX_LENGTH || memcmp( data, EGZ_FILE_ID, strlen( EGZ_FILE_ID ) ) != 0 )
+    {
+        return EGZ_ERROR_INVALID_FORMAT;
+    }
+    
+    memcpy( &header_length, data + strlen( EGZ_FILE_ID ), sizeof( uint16_t ) );
+    
+    /* Smallest header: options + original file size + checksum + number of symbols */
+    if( header_length < 44 || length < EGZ_HEADER_PREFIX_LENGTH + ( size_t )header_length )
+    {
+        return EGZ_ERROR_INVALID_FORMAT;
+    }
+    
+    if( memcmp( data + 5, EGZ_FILE_HEADER_ID, 3 ) == 0 )
+    {
+        header->v1 = false;
+    }
+    else if( memcmp( data + 5, EGZ_FILE_HEADER_V1_ID, 3 ) == 0 )
+    {
+        header->v1 = true;
+    }
+    else
+    {
+        return EGZ_ERROR_INVALID_FORMAT;
+    }
+    
+    header->length = EGZ_HEADER_PREFIX_LENGTH + header_length;
+    data          += EGZ_HEADER_PREFIX_LENGTH;
+    
+    /* Version 1 headers have no options byte */
+    header->flags = ( header->v1 == true ) ? 0 : *( data );
+    data         += ( header->v1 == true ) ? 0 : 1;
+    
+    /* Unknown options - Blocks have their own streams, and only blocks can be streamed, use a pre-trained table or another checksum than MD5 */
+    if( ( header->flags & ~( EGZ_HEADER_FLAG_STREAMS | EGZ_HEADER_FLAG_BLOCKS | EGZ_HEADER_FLAG_STREAMED | EGZ_HEADER_FLAG_TABLE_ID | EGZ_HEADER_CHECKSUM_MASK ) ) != 0 || ( ( header->flags & EGZ_HEADER_FLAG_STREAMS ) != 0 && ( header->flags & EGZ_HEADER_FLAG_BLOCKS ) != 0 ) || ( ( header->flags & ( EGZ_HEADER_FLAG_STREAMED | EGZ_HEADER_FLAG_TABLE_ID | EGZ_HEADER_CHECKSUM_MASK ) ) != 0 && ( header->flags & EGZ_HEADER_FLAG_BLOCKS ) == 0 ) )
+    {
+        return EGZ_ERROR_INVALID_FORMAT;
+    }
+    
+    header->checksum        = ( data + sizeof( uint64_t ) );
+    header->checksum_type   = ( header->flags & EGZ_HEADER_CHECKSUM_MASK ) >> EGZ_HEADER_CHECKSUM_SHIFT;
+    header->original_length = ( ( uint64_t )( *( data + 7 ) ) << 56 )
+                            | ( ( uint64_t )( *( data + 6 ) ) << 48 )
+                            | ( ( uint64_t )( *( data + 5 ) ) << 40 )
+                            | ( ( uint64_t )( *( data + 4 ) ) << 32 )
+                            | ( ( uint64_t )( *( data + 3 ) ) << 24 )
+                            | ( ( uint64_t )( *( data + 2 ) ) << 16 )
+                            | ( ( uint64_t )( *( data + 1 ) ) << 8 )
+                            |   ( uint64_t )( *( data ) );
+    
+    /* Symbols (after the size and checksum) - Raw codes for version 1, code lengths otherwise */
+    header->symbols        = data + sizeof( uint64_t ) + EGZ_CHECKSUM_LENGTH;
+    header->symbols_length = ( header->v1 == true ) ? header_length - 43 : header_length - 42;
+    header->table_id       = 0;
+    
+    /* Pre-trained table - Only its ID is stored */
+    if( ( header->flags & EGZ_HEADER_FLAG_TABLE_ID ) != 0 )
+    {
+        if( header->symbols_length < sizeof( uint64_t ) )
+        {
+            return EGZ_ERROR_INVALID_FORMAT;
+        }
+        
+        memcpy( &( header->table_id ), header->symbols, sizeof( uint64_t ) );
+    }
+    
+    return EGZ_OK;
+}
+
+unsigned int egz_rebuild_lengths( unsigned char * data, unsigned char * lengths, uint16_t length )
+{
+    unsigned int i;
+    unsigned int count;
+    
+    memset( lengths, 0, 256 );
+    
+    /* Not even the number of symbols */
+    if( length < 2 )
+    {
+        return 0;
+    }
+    
+    count = ( ( uint8_t )( *( data + 1 ) ) << 8 ) | ( uint8_t )( *( data ) );
+    data += 2;
+    
+    DEBUG( "%u symbols are present in the file", count );
+    
+    if( count == 0 || count > 256 )
+    {
+        return 0;
+    }
+    
+    /* Code lengths are stored either as a full table or as (symbol, length) pairs */
+    if( count > EGZ_HEADER_LENGTHS_PAIRS )
+    {
+        if( length < 2 + 256 )
+        {
+            return 0;
+        }
+        
+        memcpy( lengths, data, 256 );
+    }
+    else
+    {
+        if( length < 2 + count * 2 )
+        {
+            return 0;
+        }
+        
+        for( i = 0; i < count; i++ )
+        {
+            lengths[ data[ i * 2 ] ] = data[ i * 2 + 1 ];
+        }
+    }
+    
+    return count;
+}
+
 unsigned int egz_rebuild_symbols( unsigned char * data, egz_symbol ** symbols_ptr, uint16_t length )
 {
     unsigned char c;
     unsigned int  i;
+    unsigned int  n;
     unsigned int  count;
     egz_symbol *  s;
     egz_symbol *  symbols;
     egz_symbol ** symbols_debug;
     
     i             = 0;
+    n             = 0;
     count         = ( ( uint8_t )( *( data + 1 ) ) << 8 ) | ( uint8_t )( *( data ) );
     data         += 2;
     symbols_debug = NULL;
@@ -185,7 +395,7 @@ unsigned int egz_rebuild_symbols( unsigned char * data, egz_symbol ** symbols_pt
     DEBUG( "%u symbols are present in the file", count );
     DEBUG( "Getting information about each symbol" );
     
-    while( i < length )
+    while( i < length && n++ < count )
     {
         c             = *( data++ );
         s             = symbols;
@@ -264,13 +474,8 @@ unsigned int egz_rebuild_symbols( unsigned char * data, egz_symbol ** symbols_pt
 
 egz_status egz_rebuild_tree( egz_symbol ** tree_ptr, egz_symbol * symbols, unsigned int count )
 {
-    unsigned char code;
-    uint64_t      mask;
-    unsigned int  bits;
     unsigned int  i;
-    unsigned int  j;
     int           k;
-    unsigned int  bytes;
     unsigned int  node_id;
     egz_symbol  * tree;
     egz_symbol  * branch;
@@ -288,7 +493,6 @@ egz_status egz_rebuild_tree( egz_symbol ** tree_ptr, egz_symbol * symbols, unsig
     node          = tree;
     *( tree_ptr ) = tree;
     i             = 0;
-    j             = 0;
     k             = 0;
     
     for( i = 0; i < count - 1; i++ )
@@ -310,79 +514,70 @@ egz_status egz_rebuild_tree( egz_symbol ** tree_ptr, egz_symbol * symbols, unsig
     {
         s = &( symbols[ i ] );
         
-        if( s->bits > 32 )
-        {
-            bytes = 8;
-        }
-        else if( s->bits > 16 )
-        {
-            bytes = 4;
-        }
-        else if( s->bits > 8 )
-        {
-            bytes = 2;
-        }
-        else
+        EGZ_TRACE_SYMBOL( EGZ_TRACE_TREE_SYMBOL, s->character, s->bits, s->code );
+        
+        if( s->bits == 0 || s->bits > EGZ_BTREE_CODE_MAX_LENGTH )
         {
-            bytes = 1;
+            return EGZ_ERROR_INVALID_TREE;
         }
         
-        for( j = 0; j < bytes; j++ )
+        for( k = s->bits - 1; k > -1; k-- )
         {
-            mask = ( uint64_t )( 0xFF << ( ( j ) * 8 ) );
-            code = ( unsigned char )( ( s->code & mask ) >> ( ( j ) * 8 ) );
-            bits = ( bytes == 1 || ( j > 0 && j == bytes - 1 ) ) ? s->bits : 8;
-            
-            DEBUG( "Processing character 0x%02X (%c) - %u bits", s->character, ( isprint( s->character ) && s->character != 0x20 ) ? s->character : '.', s->bits );
-            
-            for( k = bits - 1; k > -1; k-- )
+            if( ( s->code >> k ) & 1 )
             {
-                if( code & ( 1 << k ) )
+                if( k == 0 )
                 {
-                    if( k == 0 )
-                    {
-                        DEBUG( "Placing right symbol: 0x%02X (%c)", s->character, ( isprint( s->character ) && s->character != 0x20 ) ? s->character : '.' );
-                        
-                        branch->right = s;
-                    }
-                    else if( branch->right == NULL )
-                    {
-                        node++;
-                        
-                        DEBUG( "    - Creating new internal right node: #%u", node->id );
-                        
-                        branch->right = node;
-                        branch        = branch->right;
-                        
-                    }
-                    else
+                    EGZ_TRACE_SYMBOL( EGZ_TRACE_TREE_LEAF, s->character, 1, branch->id );
+                    
+                    branch->right = s;
+                }
+                else if( branch->right == NULL )
+                {
+                    if( node == &( tree[ count - 2 ] ) )
                     {
-                        DEBUG( "    - Moving on right branch: #%u", branch->right->id );
-                        branch = branch->right;
+                        return EGZ_ERROR_INVALID_TREE;
                     }
+                    
+                    node++;
+                    
+                    EGZ_TRACE_SYMBOL( EGZ_TRACE_TREE_NODE, node->id, 1, branch->id );
+                    
+                    branch->right = node;
+                    branch        = branch->right;
+                    
                 }
                 else
                 {
-                    if( k == 0 )
-                    {
-                        DEBUG( "Placing left symbol:  0x%02X (%c)", s->character, ( isprint( s->character ) && s->character != 0x20 ) ? s->character : '.' );
-                        
-                        branch->left = s;
-                    }
-                    else if( branch->left == NULL )
-                    {
-                        node++;
-                        
-                        DEBUG( "    - Creating new internal left node:  #%u", node->id );
-                        
-                        branch->left = node;
-                        branch       = branch->left;
-                    }
-                    else
+                    EGZ_TRACE_SYMBOL( EGZ_TRACE_TREE_BRANCH, branch->right->id, 1, branch->id );
+                    branch = branch->right;
+                }
+            }
+            else
+            {
+                if( k == 0 )
+                {
+                    EGZ_TRACE_SYMBOL( EGZ_TRACE_TREE_LEAF, s->character, 0, branch->id );
+                    
+                    branch->left = s;
+                }
+                else if( branch->left == NULL )
+                {
+                    if( node == &( tree[ count - 2 ] ) )
                     {
-                        DEBUG( "    - Moving on left  branch: #%u", branch->left->id );
-                        branch = branch->left;
+                        return EGZ_ERROR_INVALID_TREE;
                     }
+                    
+                    node++;
+                    
+                    EGZ_TRACE_SYMBOL( EGZ_TRACE_TREE_NODE, node->id, 0, branch->id );
+                    
+                    branch->left = node;
+                    branch       = branch->left;
+                }
+                else
+                {
+                    EGZ_TRACE_SYMBOL( EGZ_TRACE_TREE_BRANCH, branch->left->id, 0, branch->id );
+                    branch = branch->left;
                 }
             }
         }
@@ -431,170 +626,418 @@ egz_status egz_rebuild_tree( egz_symbol ** tree_ptr, egz_symbol * symbols, unsig
 /*!
  * 
  */
-egz_status egz_write_expanded_file( FILE * source, FILE * destination, egz_symbol * tree, uint64_t filesize )
+egz_status egz_write_expanded_file( FILE * source, FILE * destination, egz_lookup * lookup, uint64_t filesize, egz_digest * digest )
 {
-    unsigned int        i;
-    unsigned int        j;
-    uint16_t            header_length;
-    unsigned int        length;
-    unsigned long       size;
-    unsigned long       read_ops;
-    unsigned long       read_op;
-    long                offset;
-    uint64_t            bytes;
-    uint64_t            bytes_total;
-    uint64_t            c;
-    uint64_t            read_buffer[ EGZ_READ_BUFFER_LENGTH ];
-    unsigned char       write_buffer[ EGZ_WRITE_BUFFER_LENGTH ];
-    libprogressbar_args args;
-    egz_symbol        * branch;
-    char                data_id[ 4 ] = { 0, 0, 0, 0 };
-    
-    offset      = ftell( source );
-    size        = egz_getfilesize( source );
-    read_ops    = ceil( ( double )size / ( double )EGZ_READ_BUFFER_LENGTH );
-    read_op     = 0;
+    unsigned int  bits;
+    unsigned int  bytes;
+    uint64_t      bytes_total;
+    uint64_t      window;
+    unsigned char c;
+    unsigned char write_buffer[ EGZ_WRITE_BUFFER_LENGTH ];
+    egz_bitreader reader;
+    
     bytes       = 0;
     bytes_total = 0;
-    __percent   = 0;
     
-    if( libdebug_is_enabled() == false )
+    egz_progress_begin( EGZ_PROGRESS_EXPAND, filesize );
+    
+    if( egz_read_data_id( source ) == false )
     {
-        args.percent = &__percent;
-        args.length  = 50;
-        args.label   = "Expanding file:        ";
-        args.done    = "[OK]";
+        egz_progress_end();
         
-        libprogressbar_create_progressbar( ( void * )( &args ) );
+        return EGZ_ERROR_INVALID_FORMAT;
     }
     
-    fseek( source, strlen( EGZ_FILE_ID ), SEEK_SET );
-    fread( &header_length, sizeof( uint16_t ), 1, source );
-    fseek( source, header_length + strlen( EGZ_FILE_HEADER_ID ), SEEK_CUR );
+    egz_bitreader_init( &reader, source );
     
-    memset( read_buffer,  0, EGZ_READ_BUFFER_LENGTH );
-    memset( write_buffer, 0, EGZ_WRITE_BUFFER_LENGTH );
+    while( bytes_total < filesize )
+    {
+        /* Resolves a whole symbol with the first bits of the window (slow path for long codes) */
+        window = EGZ_BITREADER_PEEK( &reader );
+        
+        EGZ_LOOKUP_DECODE( lookup, window, c, bits );
+        
+        if( bits == 0 )
+        {
+            egz_progress_end();
+            
+            return EGZ_ERROR_INVALID_TREE;
+        }
+        
+        EGZ_BITREADER_SKIP( &reader, bits );
+        
+        write_buffer[ bytes++ ] = c;
+        bytes_total++;
+        
+        if( bytes == EGZ_WRITE_BUFFER_LENGTH )
+        {
+            fwrite( write_buffer, sizeof( unsigned char ), EGZ_WRITE_BUFFER_LENGTH, destination );
+            egz_digest_update( digest, write_buffer, EGZ_WRITE_BUFFER_LENGTH );
+            
+            bytes = 0;
+            
+            egz_progress_update( bytes_total );
+        }
+    }
     
-    if( fread( data_id, sizeof( uint8_t ), 3, source ) != 3 || strcmp( data_id, EGZ_FILE_DATA_ID ) != 0 )
+    if( bytes > 0 )
+    {
+        DEBUG( "Writing remaining data to the destination file" );
+        fwrite( write_buffer, sizeof( unsigned char ), bytes, destination );
+        egz_digest_update( digest, write_buffer, bytes );
+    }
+    
+    egz_progress_update( bytes_total );
+    egz_progress_end();
+    
+    return EGZ_OK;
+}
+
+/*!
+ * 
+ */
+egz_status egz_write_expanded_streams( FILE * source, FILE * destination, egz_lookup * lookup, uint64_t filesize, egz_digest * digest )
+{
+    unsigned int  i;
+    unsigned int  bytes;
+    unsigned int  chunk;
+    unsigned int  streams;
+    uint8_t       count;
+    uint64_t      size;
+    uint64_t      bytes_total;
+    uint64_t      words_total;
+    uint64_t      lengths[ EGZ_STREAMS_MAX ];
+    uint64_t    * words;
+    unsigned char write_buffer[ EGZ_WRITE_BUFFER_LENGTH ];
+    egz_bitreader readers[ EGZ_STREAMS_MAX ];
+    
+    bytes_total = 0;
+    words_total = 0;
+    
+    if( egz_read_data_id( source ) == false )
+    {
+        return EGZ_ERROR_INVALID_FORMAT;
+    }
+    
+    /* Jump table - Number of streams and length of each stream, in words */
+    if( fread( &count, sizeof( uint8_t ), 1, source ) != 1 || count < 1 || count > EGZ_STREAMS_MAX )
+    {
+        return EGZ_ERROR_INVALID_FORMAT;
+    }
+    
+    streams = count;
+    
+    if( fread( lengths, sizeof( uint64_t ), streams, source ) != streams )
+    {
+        return EGZ_ERROR_INVALID_FORMAT;
+    }
+    
+    /* No stream is longer than the rest of the file */
+    size = ( egz_getfilesize( source ) - ( unsigned long )ftell( source ) ) / sizeof( uint64_t );
+    
+    for( i = 0; i < streams; i++ )
+    {
+        if( lengths[ i ] > size )
+        {
+            return EGZ_ERROR_INVALID_FORMAT;
+        }
+        
+        words_total += lengths[ i ];
+    }
+    
+    DEBUG( "%u streams - %lu words", streams, words_total );
+    
+    /* The streams are read at once, so each one can have its own reader */
+    if( NULL == ( words = ( uint64_t * )malloc( sizeof( uint64_t ) * ( ( words_total > 0 ) ? words_total : 1 ) ) ) )
     {
+        return EGZ_ERROR_MALLOC;
+    }
+    
+    if( fread( words, sizeof( uint64_t ), words_total, source ) != words_total )
+    {
+        free( words );
         return EGZ_ERROR_INVALID_FORMAT;
     }
     
-    branch = tree;
+    words_total = 0;
+    
+    for( i = 0; i < streams; i++ )
+    {
+        egz_bitreader_init_memory( &( readers[ i ] ), ( unsigned char * )( words + words_total ), lengths[ i ] );
+        
+        words_total += lengths[ i ];
+    }
+    
+    egz_progress_begin( EGZ_PROGRESS_EXPAND, filesize );
     
-    while( ( length = fread( read_buffer, sizeof( uint64_t ), EGZ_READ_BUFFER_LENGTH, source ) ) )
+    /* Whole rounds are decoded in each chunk, so the next chunk starts with the first stream */
+    chunk = ( EGZ_WRITE_BUFFER_LENGTH / streams ) * streams;
+    
+    while( bytes_total < filesize )
     {
-        read_ops++;
+        bytes = ( filesize - bytes_total < chunk ) ? ( unsigned int )( filesize - bytes_total ) : chunk;
+        
+        if( egz_decode_streams( readers, streams, lookup, write_buffer, bytes ) != EGZ_OK )
+        {
+            egz_progress_end();
+            free( words );
+            
+            return EGZ_ERROR_INVALID_TREE;
+        }
+        
+        fwrite( write_buffer, sizeof( unsigned char ), bytes, destination );
+        egz_digest_update( digest, write_buffer, bytes );
+        
+        bytes_total += bytes;
         
-        for( i = 0; i < length; i++ )
+        egz_progress_update( bytes_total );
+    }
+    
+    egz_progress_end();
+    free( words );
+    
+    return EGZ_OK;
+}
+
+/*!
+ * 
+ */
+egz_status egz_write_expanded_blocks( FILE * source, FILE * destination, egz_lookup * lookup, uint8_t flags, uint64_t filesize, unsigned char * checksum, egz_options * options )
+{
+    bool              eof;
+    bool              streamed;
+    bool              corrupted;
+    uint64_t          bytes_read;
+    uint64_t          bytes_total;
+    uint64_t          bytes_compressed;
+    egz_pool        * pool;
+    egz_job         * job;
+    egz_digest        digest;
+    egz_block_header  header;
+    egz_block_context context;
+    egz_status        status;
+    egz_timer         timer;
+    unsigned long     blocks;
+    
+    eof              = false;
+    corrupted        = false;
+    streamed         = ( ( flags & EGZ_HEADER_FLAG_STREAMED ) != 0 ) ? true : false;
+    bytes_read       = 0;
+    bytes_total      = 0;
+    bytes_compressed = 0;
+    blocks           = 0;
+    status           = EGZ_OK;
+    context.table    = NULL;
+    context.lookup   = lookup;
+    context.options  = options;
+    
+    egz_stats_begin( &timer );
+    
+    /* The header was just read - The data follows, so the source does not need to be seekable */
+    if( egz_read_data_id( source ) == false )
+    {
+        return EGZ_ERROR_INVALID_FORMAT;
+    }
+    
+    DEBUG( "Expanding blocks with %u thread(s)", options->threads );
+    
+    if( NULL == ( pool = egz_pool_create( options->threads, egz_expand_job, &context ) ) )
+    {
+        return EGZ_ERROR_MALLOC;
+    }
+    
+    egz_digest_init( &digest, ( flags & EGZ_HEADER_CHECKSUM_MASK ) >> EGZ_HEADER_CHECKSUM_SHIFT );
+    
+    digest.stage = EGZ_STATS_VERIFY;
+    
+    /* The size of a streamed file is only known at the end */
+    egz_progress_begin( EGZ_PROGRESS_EXPAND, ( streamed == true ) ? 0 : filesize );
+    
+    while( status == EGZ_OK )
+    {
+        /* Gives the next blocks to the workers - The block headers are checked here, as they tell where the next block starts */
+        while( eof == false && NULL != ( job = egz_pool_acquire( pool ) ) )
         {
-            c = read_buffer[ i ];
+            if( streamed == false && bytes_read == filesize )
+            {
+                eof = true;
+                break;
+            }
+            
+            if( egz_block_reserve( &( job->input ), EGZ_BLOCK_HEADER_LENGTH ) == false )
+            {
+                status = EGZ_ERROR_MALLOC;
+                break;
+            }
+            
+            if( fread( job->input.data, sizeof( unsigned char ), EGZ_BLOCK_HEADER_LENGTH, source ) != EGZ_BLOCK_HEADER_LENGTH )
+            {
+                status = EGZ_ERROR_INVALID_FORMAT;
+                break;
+            }
             
-            for( j = 0; j < ( sizeof( uint64_t ) * 8 ); j++ )
+            /* End of a streamed file - The trailer has the original size and checksum */
+            if( streamed == true && egz_block_is_end( job->input.data ) == true )
             {
-                if( bytes_total == filesize )
+                if( fread( &filesize, sizeof( uint64_t ), 1, source ) != 1 || fread( checksum, sizeof( char ), EGZ_CHECKSUM_LENGTH, source ) != EGZ_CHECKSUM_LENGTH )
                 {
+                    status = EGZ_ERROR_INVALID_FORMAT;
                     break;
                 }
                 
-                if( ( c >> ( ( ( sizeof( uint64_t ) * 8 ) - 1 ) - j ) ) & 1 )
-                {
-                    DEBUG( "        - Moving on right branch: #%u", branch->right->id );
-                    branch = branch->right;
-                }
-                else
-                {
-                    DEBUG( "        - Moving on left  branch: #%u", branch->left->id );
-                    branch = branch->left;
-                }
-                
-                if( branch->bits > 0 )
-                {
-                    DEBUG( "    - Found character 0x%02X (%c) - %u bits", branch->character, ( isprint( branch->character ) && branch->character != 0x20 ) ? branch->character : '.', branch->bits );
-                    write_buffer[ bytes ] = branch->character;
-                    
-                    bytes++;
-                    bytes_total++;
-                    
-                    if( bytes == EGZ_WRITE_BUFFER_LENGTH )
-                    {
-                        DEBUG( "Writing data to the destination file" );
-                        fwrite( write_buffer, sizeof( unsigned char ), EGZ_WRITE_BUFFER_LENGTH, destination );
-                        memset( write_buffer, 0, EGZ_WRITE_BUFFER_LENGTH );
-                        
-                        bytes = 0;
-                    }
-                    
-                    DEBUG( "    - Moving on tree top" );
-                    branch = tree;
-                    
-                }
+                checksum[ EGZ_CHECKSUM_LENGTH - 1 ] = 0;
+                eof                                 = true;
+                break;
+            }
+            
+            if( EGZ_OK != ( status = egz_read_block_header( job->input.data, &header ) ) )
+            {
+                break;
             }
             
-            if( bytes_total == filesize )
+            if( header.original_length == 0 || ( streamed == false && header.original_length > filesize - bytes_read ) )
             {
+                status = EGZ_ERROR_INVALID_FORMAT;
                 break;
             }
+            
+            /* The block header is kept, as it was already read */
+            if( egz_block_reserve( &( job->input ), EGZ_BLOCK_HEADER_LENGTH + header.payload_length ) == false )
+            {
+                status = EGZ_ERROR_MALLOC;
+                break;
+            }
+            
+            if( fread( job->input.data + EGZ_BLOCK_HEADER_LENGTH, sizeof( unsigned char ), header.payload_length, source ) != header.payload_length )
+            {
+                status = EGZ_ERROR_INVALID_FORMAT;
+                break;
+            }
+            
+            job->input.length = EGZ_BLOCK_HEADER_LENGTH + header.payload_length;
+            job->data         = job->input.data;
+            job->length       = job->input.length;
+            bytes_read       += header.original_length;
+            bytes_compressed += job->input.length;
+            
+            egz_pool_submit( pool, job );
+        }
+        
+        /* Blocks are written in the file order, whatever the thread that expanded them */
+        if( status != EGZ_OK || NULL == ( job = egz_pool_collect( pool ) ) )
+        {
+            break;
         }
         
-        if( read_ops > 1 )
+        status = job->status;
+        
+        corrupted = ( status != EGZ_OK ) ? true : false;
+        
+        if( status == EGZ_OK )
         {
-            __percent = ( ( double )read_op / ( double )read_ops ) * 100;
+            EGZ_TRACE_BLOCK( EGZ_TRACE_BLOCK_EXPANDED, blocks + 1, job->length, job->output.length );
+            fwrite( job->output.data, sizeof( unsigned char ), job->output.length, destination );
+            
+            egz_digest_update( &digest, job->output.data, job->output.length );
+            
+            bytes_total += job->output.length;
+            blocks++;
+            
+            egz_progress_update( bytes_total );
         }
+        
+        egz_pool_release( pool, job );
     }
     
-    if( bytes > 0 )
+    egz_progress_end();
+    egz_pool_destroy( pool );
+    
+    /* The workers are part of the decoding time - The output checksum is counted apart */
+    egz_stats_end( &timer, EGZ_STATS_DECODE, bytes_compressed, bytes_total );
+    
+    /* Corrupted data is reported for the block where it is */
+    if( corrupted == true )
     {
-        DEBUG( "Writing remaining data to the destination file" );
-        fwrite( write_buffer, sizeof( unsigned char ), bytes, destination );
+        printf( "Warning: block %lu (at byte %llu of the original file) cannot be expanded: %s.\n", blocks, ( unsigned long long )bytes_total, egz_error_str( status ) );
     }
     
-    __percent = 100;
+    if( status == EGZ_OK )
+    {
+        status = ( eof == false || bytes_total != filesize ) ? EGZ_ERROR_INVALID_FORMAT : egz_verify_checksum( &digest, checksum );
+    }
+    
+    return status;
+}
+
+/*!
+ * 
+ */
+static egz_status egz_expand_job( egz_job * job, void * context )
+{
+    egz_block_header    header;
+    egz_block_context * block_context;
+    egz_status          status;
     
-    libprogressbar_end();
+    block_context = ( egz_block_context * )context;
     
-    return EGZ_OK;
+    /* Already checked when the block was read */
+    egz_read_block_header( job->data, &header );
+    
+    if( egz_block_reserve( &( job->output ), header.original_length ) == false )
+    {
+        return EGZ_ERROR_MALLOC;
+    }
+    
+    status             = egz_expand_block( job->data + EGZ_BLOCK_HEADER_LENGTH, &header, block_context->lookup, job->output.data );
+    job->output.length = ( status == EGZ_OK ) ? header.original_length : 0;
+    
+    return status;
 }
 
 /*!
  * 
  */
-egz_status egz_verify_checksum( FILE * destination, unsigned char * checksum )
+static bool egz_read_data_id( FILE * source )
 {
-    char answer[ 1 ];
-    char md5[ MD5_DIGEST_LENGTH * 2 + 1 ];
+    char data_id[ 4 ] = { 0, 0, 0, 0 };
     
-    DEBUG( "Getting destination file MD5 checksum" );
-    egz_file_md5_checksum( destination, md5 );
-    DEBUG( "New MD5 checksum:      %s", md5 );
-    DEBUG( "Original MD5 checksum: %s", checksum );
-    DEBUG( "Verifiying MD5 checksum:" );
+    if( fread( data_id, sizeof( uint8_t ), 3, source ) != 3 || strcmp( data_id, EGZ_FILE_DATA_ID ) != 0 )
+    {
+        return false;
+    }
     
-    if( strcmp( ( char * )checksum, md5 ) != 0 )
+    return true;
+}
+
+/*!
+ * 
+ */
+egz_status egz_verify_checksum( egz_digest * digest, unsigned char * checksum )
+{
+    char hash[ EGZ_CHECKSUM_LENGTH ];
+    
+    egz_digest_final( digest, hash );
+    
+    DEBUG( "New %s checksum:      %s", egz_get_checksum_name( digest->type ), hash );
+    DEBUG( "Original %s checksum: %s", egz_get_checksum_name( digest->type ), checksum );
+    
+    if( strcmp( ( char * )checksum, hash ) != 0 )
     {
         printf
         (
-         "Warning: the original file MD5 checksum does not correspond to the expanded file.\n"
-         "\n"
-         "Original checksum: %s\n"
-         "New checksum:      %s\n"
-         "\n"
-         "Do you still want to continue? [y/N]\n",
-         checksum,
-         md5
-         );
-        
-        scanf( "%c", answer );
-        
-        if( *( answer ) != 'y' && *( answer ) != 'Y' )
-        {
-            return EGZ_ERROR_ABORT;
-        }
-    }
-    else
-    {
-        DEBUG( "MD5 checksum successfully verified" );
+            "Warning: the original file %s checksum does not correspond to the expanded file.\n"
+            "\n"
+            "Original checksum: %s\n"
+            "New checksum:      %s\n",
+            egz_get_checksum_name( digest->type ),
+            checksum,
+            hash
+        );
+        
+        return EGZ_ERROR_INVALID_CHECKSUM;
     }
     
+    DEBUG( "Checksum successfully verified" );
+    
     return EGZ_OK;
 }
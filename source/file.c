@@ -41,12 +41,14 @@
 /*!
  * 
  */
-bool egz_get_destination_filename( char * source, char * filename, bool compress )
+bool egz_get_destination_filename( char * source, char * filename, bool compress, bool in_place )
 {
     int    i;
     size_t length;
     size_t length_ext;
+    size_t prefix;
     char * basename;
+    char * name;
     bool   add_ext;
     char   suffix[ 10 ] = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
     
@@ -69,28 +71,39 @@ bool egz_get_destination_filename( char * source, char * filename, bool compress
     /* Gets the string length */
     length = strlen( basename );
     
+    /* The destination is created next to the source, or in the current directory */
+    prefix = ( in_place == true ) ? ( size_t )( basename - source ) : 0;
+    
+    if( prefix + length + length_ext >= FILENAME_MAX )
+    {
+        return false;
+    }
+    
     /* Resets the buffer */
     memset( filename, 0, FILENAME_MAX );
+    memcpy( filename, source, prefix );
+    
+    name = filename + prefix;
     
     /* Checks if we need to remove or add the file extension */
     if( compress == true )
     {
         /* Copies the file name and add the extension */
         add_ext = true;
-        strcpy( filename, basename );
-        strcat( filename, EGZ_FILE_EXT );
+        strcpy( name, basename );
+        strcat( name, EGZ_FILE_EXT );
     }
     else if( strcmp( basename + length - length_ext, EGZ_FILE_EXT ) == 0 )
     {
         /* Copies the file name, without the extension */
         add_ext = false;
-        strncpy( filename, basename, length - length_ext );
+        strncpy( name, basename, length - length_ext );
     }
     else
     {
         /* Copies the file name, without the extension */
         add_ext = false;
-        strncpy( filename, basename, length );
+        strncpy( name, basename, length );
     }
     
     i = 0;
@@ -110,27 +123,27 @@ bool egz_get_destination_filename( char * source, char * filename, bool compress
         if( add_ext == false )
         {
             /* Not enough space for the filename */
-            if( strlen( suffix ) + length - length_ext > FILENAME_MAX )
+            if( prefix + strlen( suffix ) + length - length_ext >= FILENAME_MAX )
             {
                 break;
             }
             
             /* Adds the suffix */
-            strncpy( filename, basename, length - length_ext );
-            strcat( filename, suffix );
+            strncpy( name, basename, length - length_ext );
+            strcat( name, suffix );
         }
         else
         {
             /* Not enough space for the filename */
-            if( strlen( suffix ) + length + length_ext > FILENAME_MAX )
+            if( prefix + strlen( suffix ) + length + length_ext >= FILENAME_MAX )
             {
                 break;
             }
             
             /* Adds the suffix */
-            strcpy( filename, basename );
-            strcat( filename, suffix );
-            strcat( filename, EGZ_FILE_EXT );
+            strcpy( name, basename );
+            strcat( name, suffix );
+            strcat( name, EGZ_FILE_EXT );
         }
     }
     
@@ -202,3 +215,51 @@ double egz_getfilesize_human( FILE * fp, char * unit )
     
     return size;
 }
+
+/*!
+ * 
+ */
+bool egz_map_file( FILE * fp, egz_mapping * mapping )
+{
+    struct stat   info;
+    void        * data;
+    
+    mapping->data   = NULL;
+    mapping->length = 0;
+    
+    /* Pending writes must reach the file before it is mapped */
+    fflush( fp );
+    
+    /* Only regular files can be mapped - Pipes use buffered reads */
+    if( fstat( fileno( fp ), &info ) != 0 || S_ISREG( info.st_mode ) == 0 || info.st_size == 0 )
+    {
+        return false;
+    }
+    
+    if( MAP_FAILED == ( data = mmap( NULL, ( size_t )info.st_size, PROT_READ, MAP_PRIVATE, fileno( fp ), 0 ) ) )
+    {
+        return false;
+    }
+    
+    /* Every pass reads the file from the start to the end */
+    madvise( data, ( size_t )info.st_size, MADV_SEQUENTIAL );
+    
+    mapping->data   = ( unsigned char * )data;
+    mapping->length = ( size_t )info.st_size;
+    
+    return true;
+}
+
+/*!
+ * 
+ */
+void egz_unmap_file( egz_mapping * mapping )
+{
+    if( mapping->data != NULL )
+    {
+        munmap( mapping->data, mapping->length );
+    }
+    
+    mapping->data   = NULL;
+    mapping->length = 0;
+}
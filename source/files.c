@@ -0,0 +1,400 @@
+/*******************************************************************************
+ * Copyright (c) 2010, Jean-David Gadina - www.xs-labs.com
+ * Distributed under the Boost Software License, Version 1.0.
+ * 
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ * 
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ * 
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ******************************************************************************/
+
+/* $Id$ */
+
+/*!
+ * @file        files.c
+ * @copyright   (c) 2011 - Jean-David Gadina - www.xs-labs.com
+ * @abstract    Batch processing of several files
+ */
+
+/* Local includes */
+#include "egz.h"
+
+/* Private functions */
+static egz_status egz_files_add_path( egz_files * files, char * path, bool recursive, bool compress, bool explicit );
+static egz_status egz_files_add_directory( egz_files * files, char * path, bool compress );
+static bool       egz_files_has_extension( char * path );
+static egz_status egz_files_task( egz_task * task, void * context );
+
+/*!
+ * 
+ */
+void egz_files_init( egz_files * files )
+{
+    files->tasks    = NULL;
+    files->count    = 0;
+    files->capacity = 0;
+    files->errors   = 0;
+}
+
+/*!
+ * 
+ */
+void egz_files_free( egz_files * files )
+{
+    size_t i;
+    
+    for( i = 0; i < files->count; i++ )
+    {
+        free( files->tasks[ i ].path );
+        free( files->tasks[ i ].destination );
+    }
+    
+    free( files->tasks );
+    egz_files_init( files );
+}
+
+/*!
+ * 
+ */
+egz_status egz_files_add( egz_files * files, char * path, bool recursive, bool compress )
+{
+    return egz_files_add_path( files, path, recursive, compress, true );
+}
+
+/*!
+ * 
+ */
+egz_status egz_files_read_list( egz_files * files, char * list, bool recursive, bool compress )
+{
+    FILE     * fp;
+    size_t     length;
+    egz_status status;
+    char       line[ FILENAME_MAX ];
+    
+    /* The list may come from the standard input (find . -type f | egz -c --files-from -) */
+    if( strcmp( list, EGZ_STDIO_NAME ) == 0 )
+    {
+        fp = stdin;
+    }
+    else if( NULL == ( fp = fopen( list, "rb" ) ) )
+    {
+        return EGZ_ERROR_FILE;
+    }
+    
+    status = EGZ_OK;
+    
+    /* One path per line - Empty lines are ignored */
+    while( status == EGZ_OK && fgets( line, FILENAME_MAX, fp ) != NULL )
+    {
+        length = strlen( line );
+        
+        while( length > 0 && ( line[ length - 1 ] == '\n' || line[ length - 1 ] == '\r' ) )
+        {
+            line[ --length ] = 0;
+        }
+        
+        if( length == 0 )
+        {
+            continue;
+        }
+        
+        status = egz_files_add_path( files, line, recursive, compress, true );
+    }
+    
+    if( fp != stdin )
+    {
+        fclose( fp );
+    }
+    
+    return status;
+}
+
+/*!
+ * 
+ */
+egz_status egz_files_process( egz_files * files, egz_options * options, bool compress, unsigned int threads, unsigned long * failures )
+{
+    size_t              i;
+    bool                report;
+    uint64_t            total;
+    uint64_t            done;
+    egz_task          * task;
+    egz_scheduler     * scheduler;
+    egz_files_context   context;
+    
+    total = 0;
+    done  = 0;
+    
+    for( i = 0; i < files->count; i++ )
+    {
+        total += files->tasks[ i ].size;
+    }
+    
+    /* Each file is handled by a single thread - The files are the unit of parallelism */
+    context.options         = *( options );
+    context.options.threads = 1;
+    context.options.quiet   = true;
+    context.compress        = compress;
+    
+    pthread_mutex_init( &( context.mutex ), NULL );
+    
+    if( NULL == ( scheduler = egz_scheduler_create( files->tasks, files->count, threads, egz_files_task, &context ) ) )
+    {
+        pthread_mutex_destroy( &( context.mutex ) );
+        
+        return EGZ_ERROR_MALLOC;
+    }
+    
+    DEBUG( "Processing %lu file(s) with %u thread(s)", ( unsigned long )files->count, threads );
+    
+    /* The file names are printed as they complete, so the terminal bar is only replaced by the descriptor */
+    report = egz_progress_is_enabled();
+    
+    if( report == true )
+    {
+        egz_progress_begin( EGZ_PROGRESS_FILES, total );
+    }
+    
+    /* Each file is reported once it is done, whatever the order */
+    while( NULL != ( task = egz_scheduler_collect( scheduler ) ) )
+    {
+        done += task->size;
+        
+        if( task->status == EGZ_OK )
+        {
+            printf
+            (
+                "%s -> %s (%.2f MB -> %.2f MB)\n",
+                task->path,
+                task->destination,
+                ( ( double )task->size / ( double )1000 ) / ( double )1000,
+                ( ( double )task->output_size / ( double )1000 ) / ( double )1000
+            );
+        }
+        else
+        {
+            fprintf( stderr, "Error: Unable to %s file %s. Reason: %s.\n", ( compress == true ) ? "compress" : "expand", task->path, egz_error_str( task->status ) );
+            
+            ( *( failures ) )++;
+        }
+        
+        if( report == true )
+        {
+            egz_progress_update( done );
+        }
+    }
+    
+    if( report == true )
+    {
+        egz_progress_end();
+    }
+    
+    egz_scheduler_destroy( scheduler );
+    pthread_mutex_destroy( &( context.mutex ) );
+    
+    return EGZ_OK;
+}
+
+/*!
+ * 
+ */
+static egz_status egz_files_add_path( egz_files * files, char * path, bool recursive, bool compress, bool explicit )
+{
+    struct stat   info;
+    egz_task    * tasks;
+    egz_task    * task;
+    
+    /* Symbolic links are only followed when named explicitly, so a tree cannot loop */
+    if( ( ( explicit == true ) ? stat( path, &info ) : lstat( path, &info ) ) != 0 )
+    {
+        /* A missing file is reported, the other ones are still processed */
+        fprintf( stderr, "Error: Source file does not exist: %s\n", path );
+        
+        files->errors++;
+        
+        return EGZ_OK;
+    }
+    
+    if( S_ISDIR( info.st_mode ) )
+    {
+        if( recursive == false )
+        {
+            fprintf( stderr, "Warning: %s is a directory (use -r) - Skipped\n", path );
+            
+            return EGZ_OK;
+        }
+        
+        return egz_files_add_directory( files, path, compress );
+    }
+    
+    if( S_ISREG( info.st_mode ) == 0 )
+    {
+        return EGZ_OK;
+    }
+    
+    /* In a tree, compressing skips the compressed files, and expanding only takes them */
+    if( explicit == false && egz_files_has_extension( path ) == compress )
+    {
+        return EGZ_OK;
+    }
+    
+    if( files->count == files->capacity )
+    {
+        if( NULL == ( tasks = ( egz_task * )realloc( files->tasks, sizeof( egz_task ) * ( ( files->capacity > 0 ) ? files->capacity * 2 : 64 ) ) ) )
+        {
+            return EGZ_ERROR_MALLOC;
+        }
+        
+        files->tasks    = tasks;
+        files->capacity = ( files->capacity > 0 ) ? files->capacity * 2 : 64;
+    }
+    
+    task = &( files->tasks[ files->count ] );
+    
+    if( NULL == ( task->path = ( char * )malloc( strlen( path ) + 1 ) ) )
+    {
+        return EGZ_ERROR_MALLOC;
+    }
+    
+    strcpy( task->path, path );
+    
+    task->destination = NULL;
+    task->size        = ( uint64_t )info.st_size;
+    task->output_size = 0;
+    task->output      = NULL;
+    task->status      = EGZ_OK;
+    
+    files->count++;
+    
+    return EGZ_OK;
+}
+
+/*!
+ * 
+ */
+static egz_status egz_files_add_directory( egz_files * files, char * path, bool compress )
+{
+    DIR             * dir;
+    struct dirent   * entry;
+    egz_status        status;
+    char              child[ FILENAME_MAX ];
+    
+    if( NULL == ( dir = opendir( path ) ) )
+    {
+        fprintf( stderr, "Warning: cannot read the directory %s - Skipped\n", path );
+        
+        return EGZ_OK;
+    }
+    
+    status = EGZ_OK;
+    
+    while( status == EGZ_OK && NULL != ( entry = readdir( dir ) ) )
+    {
+        if( strcmp( entry->d_name, "." ) == 0 || strcmp( entry->d_name, ".." ) == 0 )
+        {
+            continue;
+        }
+        
+        if( snprintf( child, FILENAME_MAX, "%s/%s", path, entry->d_name ) >= FILENAME_MAX )
+        {
+            continue;
+        }
+        
+        status = egz_files_add_path( files, child, true, compress, false );
+    }
+    
+    closedir( dir );
+    
+    return status;
+}
+
+/*!
+ * 
+ */
+static bool egz_files_has_extension( char * path )
+{
+    size_t length;
+    
+    length = strlen( path );
+    
+    return ( length > strlen( EGZ_FILE_EXT ) && strcmp( path + length - strlen( EGZ_FILE_EXT ), EGZ_FILE_EXT ) == 0 ) ? true : false;
+}
+
+/*!
+ * 
+ */
+static egz_status egz_files_task( egz_task * task, void * context )
+{
+    FILE              * source;
+    FILE              * destination;
+    egz_files_context * files;
+    egz_options         options;
+    egz_status          status;
+    char                filename[ FILENAME_MAX ];
+    
+    files   = ( egz_files_context * )context;
+    options = files->options;
+    
+    if( NULL == ( source = fopen( task->path, "rb" ) ) )
+    {
+        return EGZ_ERROR_FILE;
+    }
+    
+    /* The name is chosen and the file created at once, so two workers cannot pick the same one */
+    pthread_mutex_lock( &( files->mutex ) );
+    
+    if( egz_get_destination_filename( task->path, filename, files->compress, true ) == false || NULL == ( destination = fopen( filename, "wb+" ) ) )
+    {
+        pthread_mutex_unlock( &( files->mutex ) );
+        fclose( source );
+        
+        return EGZ_ERROR_FILE;
+    }
+    
+    pthread_mutex_unlock( &( files->mutex ) );
+    
+    status = ( files->compress == true ) ? egz_compress( source, destination, &options ) : egz_expand( source, destination, &options );
+    
+    if( status == EGZ_OK )
+    {
+        task->output_size = egz_getfilesize( destination );
+        
+        if( NULL != ( task->destination = ( char * )malloc( strlen( filename ) + 1 ) ) )
+        {
+            strcpy( task->destination, filename );
+        }
+    }
+    
+    fclose( source );
+    fclose( destination );
+    
+    if( status != EGZ_OK )
+    {
+        remove( filename );
+    }
+    else if( task->destination == NULL )
+    {
+        status = EGZ_ERROR_MALLOC;
+    }
+    
+    return status;
+}
@@ -66,7 +66,7 @@ void egz_print_usage( char * name )
         "EGZ - Compression utility (%s)\n"
         "Copyright (c) 2011 XS-Labs - Jean-David Gadina - www.xs-labs.co\n"
         "\n"
-        "Usage: %s [OPTIONS] [SOURCE_FILE]\n"
+        "Usage: %s [OPTIONS] [SOURCE_FILE...]\n"
         "\n"
         "Options:\n"
         "    \n"
@@ -76,8 +76,72 @@ void egz_print_usage( char * name )
         "    -x | --expand\n"
         "    Decompress SOURCE_FILE\n"
         "    \n"
+        "    -r | --recursive\n"
+        "    Process the files of the directories given as SOURCE_FILE, and of their subdirectories\n"
+        "    Compressing skips the %s files, expanding only takes them\n"
+        "    \n"
+        "    --files-from LIST\n"
+        "    Also process the files listed in LIST, one per line (- for the standard input)\n"
+        "    \n"
+        "    Several files are spread over the threads (-T), each one written next to its source\n"
+        "    A line is printed as each file is done, and the exit status is 1 if any file failed\n"
+        "    \n"
+        "    --archive ARCHIVE\n"
+        "    With -c, compress SOURCE_FILE... into the single file ARCHIVE, with an index of its members at the end\n"
+        "    With -x, expand the members of ARCHIVE named as SOURCE_FILE..., or all of them, in the current directory\n"
+        "    The members are compressed in memory by the threads (-T), so a pre-trained table (--table) cannot be used\n"
+        "    Each member is found from the index, and expanded from the archive with a single seek\n"
+        "    \n"
+        "    -l | --list\n"
+        "    List the members of the archive (--archive ARCHIVE, or SOURCE_FILE): sizes, checksum and name\n"
+        "    \n"
         "    -f | --force\n"
-        "    Force compression, even if compressed file may be larger\n"
+        "    Kept for compatibility - Incompressible blocks are always stored as they are\n"
+        "    \n"
+        "    --max-code-bits N\n"
+        "    Maximum length of a symbol code, in bits (%u - %u, default %u)\n"
+        "    Shorter codes decode faster, at a small cost in compression ratio\n"
+        "    \n"
+        "    --streams N\n"
+        "    Number of interleaved bitstreams (1 - %u, default %u)\n"
+        "    Symbols are spread over the streams, which are decoded in parallel\n"
+        "    \n"
+        "    --block-size N\n"
+        "    Size of the compressed blocks, in KiB (%u - %u, default %u)\n"
+        "    \n"
+        "    --adaptive\n"
+        "    End the blocks where the symbol statistics change, instead of every block size\n"
+        "    A new block is only started when its own table saves more than it costs\n"
+        "    \n"
+        "    --check NAME\n"
+        "    Checksum of the original data: crc32c, xxh64, md5 or none (default %s)\n"
+        "    The algorithm is stored in the header, so expanding needs no option\n"
+        "    \n"
+        "    -s | --stdout\n"
+        "    Write to the standard output instead of a file\n"
+        "    Use - as the source to read the standard input (implies --stdout)\n"
+        "    Compressing this way uses a streamed format, with the size and checksum at the end\n"
+        "    \n"
+        "    --progress-fd N\n"
+        "    Write the progress of each stage as JSON lines to the file descriptor N, instead of the progress bar\n"
+        "    Each line has the stage, bytes done and total (0 if unknown), rate in bytes per second and ETA in seconds\n"
+        "    \n"
+        "    --stats[=FORMAT]\n"
+        "    Print the wall and CPU time, bytes in and out and throughput of each stage to the standard error\n"
+        "    FORMAT is text (default) or json - Worker threads are counted in the stage that waits for them\n"
+        "    With several files or an archive, each stage sums the time spent on every file - The CPU time is only the one of the thread processing the file\n"
+        "    \n"
+        "    -T N | --threads N\n"
+        "    Number of threads compressing or expanding the blocks (0 - %u, default %u, 0 for one per processor)\n"
+        "    The output does not depend on the number of threads\n"
+        "    \n"
+        "    --train -o TABLE_FILE SOURCE_FILE...\n"
+        "    Build a table of codes from sample files, and save it to TABLE_FILE\n"
+        "    \n"
+        "    --table TABLE_FILE\n"
+        "    Compress with a pre-trained table, without analyzing SOURCE_FILE\n"
+        "    Only the table ID is written, so the table is needed to expand the file\n"
+        "    When expanding, the table is looked for in TABLE_FILE, then in the directories of %s (default: %s)\n"
         "    \n"
         "    -h | --help\n"
         "    Print this help message\n"
@@ -89,7 +153,21 @@ void egz_print_usage( char * name )
         "    Print debug informations to stdout\n"
         "\n",
         EGZ_VERSION,
-        name
+        name,
+        EGZ_FILE_EXT,
+        EGZ_MAX_CODE_BITS_MIN,
+        EGZ_BTREE_CODE_MAX_LENGTH,
+        EGZ_MAX_CODE_BITS_DEFAULT,
+        EGZ_STREAMS_MAX,
+        EGZ_STREAMS_DEFAULT,
+        EGZ_BLOCK_SIZE_MIN / 1024,
+        EGZ_BLOCK_SIZE_MAX / 1024,
+        EGZ_BLOCK_SIZE_DEFAULT / 1024,
+        egz_get_checksum_name( EGZ_CHECKSUM_DEFAULT ),
+        EGZ_THREADS_MAX,
+        EGZ_THREADS_DEFAULT,
+        EGZ_TABLE_PATH_ENV,
+        EGZ_TABLE_PATH_DEFAULT
     );
 }
 
@@ -0,0 +1,77 @@
+/*******************************************************************************
+ * Copyright (c) 2010, Jean-David Gadina - www.xs-labs.com
+ * Distributed under the Boost Software License, Version 1.0.
+ * 
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ * 
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ * 
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ******************************************************************************/
+
+/* $Id$ */
+
+/*!
+ * @header      archive.h
+ * @copyright   (c) 2011 - Jean-David Gadina - www.xs-labs.com
+ * @abstract    Multi-member archives, with a central index
+ */
+
+#ifndef _EGZ_ARCHIVE_H_
+#define _EGZ_ARCHIVE_H_
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "types.h"
+
+    /*!
+     * 
+     */
+    egz_status egz_archive_create( char * filename, egz_files * files, egz_options * options, unsigned int threads, unsigned long * failures );
+
+    /*!
+     * 
+     */
+    egz_status egz_archive_open( char * filename, egz_archive * archive );
+
+    /*!
+     * 
+     */
+    void egz_archive_close( egz_archive * archive );
+
+    /*!
+     * 
+     */
+    void egz_archive_list( egz_archive * archive );
+
+    /*!
+     * 
+     */
+    egz_status egz_archive_extract( egz_archive * archive, char ** names, unsigned int count, egz_options * options, unsigned long * failures );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _EGZ_ARCHIVE_H_ */
@@ -0,0 +1,159 @@
+/*******************************************************************************
+ * Copyright (c) 2010, Jean-David Gadina - www.xs-labs.com
+ * Distributed under the Boost Software License, Version 1.0.
+ * 
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ * 
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ * 
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ******************************************************************************/
+
+/* $Id$ */
+
+/*!
+ * @header      bitstream.h
+ * @copyright   (c) 2011 - Jean-David Gadina - www.xs-labs.com
+ * @abstract    Bitstream functions
+ */
+
+#ifndef _EGZ_BITSTREAM_H_
+#define _EGZ_BITSTREAM_H_
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "types.h"
+
+/*!
+ * @define      EGZ_BITREADER_PEEK
+ * @abstract    Gets the next 64 bits of a bit reader, without consuming them
+ * @param       READER  The bit reader
+ */
+#define EGZ_BITREADER_PEEK( READER )                                                    \
+    (                                                                                   \
+          ( ( READER )->current << ( READER )->position )                               \
+        | ( ( ( READER )->next >> 1 ) >> ( 63 - ( READER )->position ) )                \
+    )
+
+/*!
+ * @define      EGZ_BITREADER_SKIP
+ * @abstract    Consumes bits from a bit reader (64 bits max)
+ * @param       READER  The bit reader
+ * @param       BITS    The number of bits to consume
+ */
+#define EGZ_BITREADER_SKIP( READER, BITS )                                              \
+    do                                                                                  \
+    {                                                                                   \
+        ( READER )->position += ( BITS );                                               \
+                                                                                        \
+        if( ( READER )->position >= 64 )                                                \
+        {                                                                               \
+            ( READER )->position -= 64;                                                 \
+            ( READER )->current   = ( READER )->next;                                   \
+            ( READER )->next      = egz_bitreader_load( READER );                       \
+        }                                                                               \
+    }                                                                                   \
+    while( 0 )
+
+/*!
+ * @define      EGZ_BITWRITER_PUT
+ * @abstract    Appends a code to a bit writer, without any branch
+ * @discussion  The writer must have room for the next word (see egz_bitwriter_reserve).
+ *              The current word is always stored, and only kept when it is full.
+ * @param       WRITER  The bit writer
+ * @param       CODE    The code, right-aligned
+ * @param       BITS    The length of the code (1 to 64 bits)
+ */
+#define EGZ_BITWRITER_PUT( WRITER, CODE, BITS )                                         \
+    do                                                                                  \
+    {                                                                                   \
+        uint64_t     _code;                                                             \
+        uint64_t     _full;                                                             \
+        uint64_t     _spill;                                                            \
+        unsigned int _total;                                                            \
+                                                                                        \
+        _code                = ( CODE );                                                \
+        _total               = ( WRITER )->bits + ( BITS );                             \
+        _full                = _total >> 6;                                             \
+        ( WRITER )->current |= ( _code << ( 64 - ( BITS ) ) ) >> ( WRITER )->bits;      \
+        _spill               = ( _code << ( 63 - ( _total & 63 ) ) ) << 1;              \
+                                                                                        \
+        ( WRITER )->words[ ( WRITER )->length ] = ( WRITER )->current;                  \
+                                                                                        \
+        ( WRITER )->length  += _full;                                                   \
+        ( WRITER )->bits     = _total & 63;                                             \
+        ( WRITER )->current  = ( _spill & -_full ) | ( ( WRITER )->current & ( _full - 1 ) ); \
+    }                                                                                   \
+    while( 0 )
+
+    /*!
+     * 
+     */
+    void egz_bitreader_init( egz_bitreader * reader, FILE * source );
+
+    /*!
+     * 
+     */
+    void egz_bitreader_init_memory( egz_bitreader * reader, unsigned char * data, size_t length );
+
+    /*!
+     * 
+     */
+    uint64_t egz_bitreader_load( egz_bitreader * reader );
+
+    /*!
+     * 
+     */
+    bool egz_bitwriter_init( egz_bitwriter * writer );
+
+    /*!
+     * 
+     */
+    void egz_bitwriter_reset( egz_bitwriter * writer );
+
+    /*!
+     * 
+     */
+    bool egz_bitwriter_reserve( egz_bitwriter * writer, uint64_t bits );
+
+    /*!
+     * 
+     */
+    bool egz_bitwriter_put( egz_bitwriter * writer, uint64_t code, unsigned int bits );
+
+    /*!
+     * 
+     */
+    bool egz_bitwriter_flush( egz_bitwriter * writer );
+
+    /*!
+     * 
+     */
+    void egz_bitwriter_free( egz_bitwriter * writer );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _EGZ_BITSTREAM_H_ */
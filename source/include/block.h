@@ -0,0 +1,102 @@
+/*******************************************************************************
+ * Copyright (c) 2010, Jean-David Gadina - www.xs-labs.com
+ * Distributed under the Boost Software License, Version 1.0.
+ * 
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ * 
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ * 
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ******************************************************************************/
+
+/* $Id$ */
+
+/*!
+ * @header      block.h
+ * @copyright   (c) 2011 - Jean-David Gadina - www.xs-labs.com
+ * @abstract    Block functions
+ */
+
+#ifndef _EGZ_BLOCK_H_
+#define _EGZ_BLOCK_H_
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "types.h"
+
+    /*!
+     * 
+     */
+    void egz_block_init( egz_block * block );
+
+    /*!
+     * 
+     */
+    bool egz_block_reserve( egz_block * block, size_t length );
+
+    /*!
+     * 
+     */
+    void egz_block_free( egz_block * block );
+
+    /*!
+     * 
+     */
+    egz_status egz_compress_block( unsigned char * data, size_t length, egz_table * shared, egz_options * options, egz_block * block );
+
+    /*!
+     * 
+     */
+    egz_status egz_read_block_header( unsigned char * data, egz_block_header * header );
+
+    /*!
+     * 
+     */
+    bool egz_block_is_end( unsigned char * data );
+
+    /*!
+     * 
+     */
+    size_t egz_block_bound( size_t length );
+
+    /*!
+     * 
+     */
+    size_t egz_split_block( unsigned char * data, size_t length, size_t max_length );
+
+    /*!
+     * 
+     */
+    egz_status egz_expand_block( unsigned char * data, egz_block_header * header, egz_lookup * shared, unsigned char * output );
+
+    /*!
+     * 
+     */
+    egz_status egz_decode_streams( egz_bitreader * readers, unsigned int streams, egz_lookup * lookup, unsigned char * output, size_t length );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _EGZ_BLOCK_H_ */
@@ -45,15 +45,20 @@ extern "C" {
 
 #include "types.h"
 
-    /*! 
+    /*!
+     * 
+     */
+    bool egz_create_table_codes( egz_table * table, egz_symbol ** symbols, unsigned int max_bits );
+
+    /*!
      * 
      */
-    egz_symbol * egz_create_btree( egz_symbol ** symbols, unsigned int count );
+    bool egz_create_limited_lengths( egz_symbol ** symbols, unsigned int count, unsigned int max_bits );
 
     /*!
      * 
      */
-    void egz_create_codes( egz_symbol * tree, unsigned int depth, uint64_t code );
+    void egz_create_canonical_codes( egz_table * table );
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,87 @@
+/*******************************************************************************
+ * Copyright (c) 2010, Jean-David Gadina - www.xs-labs.com
+ * Distributed under the Boost Software License, Version 1.0.
+ * 
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ * 
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ * 
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ******************************************************************************/
+
+/* $Id$ */
+
+/*!
+ * @header      buffer.h
+ * @copyright   (c) 2011 - Jean-David Gadina - www.xs-labs.com
+ * @abstract    In-memory buffer functions
+ */
+
+#ifndef _EGZ_BUFFER_H_
+#define _EGZ_BUFFER_H_
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "types.h"
+
+    /*!
+     * 
+     */
+    void egz_options_init( egz_options * options );
+
+    /*!
+     * 
+     */
+    egz_context * egz_context_create( egz_options * options );
+
+    /*!
+     * 
+     */
+    void egz_context_destroy( egz_context * context );
+
+    /*!
+     * 
+     */
+    size_t egz_compress_bound( egz_context * context, size_t length );
+
+    /*!
+     * 
+     */
+    egz_status egz_compress_buffer( egz_context * context, unsigned char * source, size_t length, unsigned char * destination, size_t capacity, size_t * written );
+
+    /*!
+     * 
+     */
+    egz_status egz_expanded_length( unsigned char * source, size_t length, uint64_t * expanded );
+
+    /*!
+     * 
+     */
+    egz_status egz_expand_buffer( unsigned char * source, size_t length, unsigned char * destination, size_t capacity, size_t * written );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _EGZ_BUFFER_H_ */
@@ -30,83 +30,92 @@
 /* $Id$ */
 
 /*!
- * @file        md5.c
+ * @header      checksum.h
  * @copyright   (c) 2011 - Jean-David Gadina - www.xs-labs.com
- * @abstract    MD5 functions
+ * @abstract    Checksum functions (MD5, CRC32C and xxHash64)
  */
 
-/* Local includes */
-#include "egz.h"
-
-/* Private variables */
-static unsigned int __percent = 0;
-
-/*!
- * 
- */
-void egz_file_md5_checksum( FILE * fp, char * hash )
-{
-    MD5_CTX             ctx;
-    size_t              length;
-    unsigned char       digest[ MD5_DIGEST_LENGTH ];
-    char                tmp[ EGZ_READ_BUFFER_LENGTH ];
-    char                hex[ 3 ] = { 0, 0, 0 };
-    long                offset;
-    unsigned int        i;
-    unsigned long       size;
-    unsigned long       read_ops;
-    unsigned long       read_op;
-    libprogressbar_args args;
-    
-    memset( hash, 0, MD5_DIGEST_LENGTH * 2 + 1 );
+/* System includes */
+#if defined( __APPLE__ )
     
-    __percent = 0;
-    size      = egz_getfilesize( fp );
-    read_ops  = ceil( ( double )size / ( double )EGZ_READ_BUFFER_LENGTH );
-    read_op   = 0;
-    __percent = 0;
+    #include <CommonCrypto/CommonDigest.h>
     
-    if( libdebug_is_enabled() == false )
-    {
-        args.percent = &__percent;
-        args.length  = 50;
-        args.label   = "Checksumming:          ";
-        args.done    = "[OK]";
+    #ifdef MD5_DIGEST_LENGTH
         
-        libprogressbar_create_progressbar( ( void * )( &args ) );
-    }
-    
-    offset = ftell( fp );
-    
-    fseek( fp, 0, SEEK_SET );
-    MD5_Init( &ctx );
-    
-    while( ( length = fread( tmp, sizeof( char ), EGZ_READ_BUFFER_LENGTH, fp ) ) )
-    {
-        read_op++;
-        
-        MD5_Update( &ctx, tmp, length );
+        #undef MD5_DIGEST_LENGTH
         
-        if( read_ops > 1 )
-        {
-            __percent = ( ( double )read_op / ( double )read_ops ) * 100;
-        }
-    }
-    
-    MD5_Final( digest, &ctx );
-    
-    for( i = 0; i < MD5_DIGEST_LENGTH; i++ )
-    {
-        sprintf( hex, "%02x", digest[ i ] );
-        strcat( hash, hex );
-        hash += 2;
-    }
+    #endif
     
-    hash -= MD5_DIGEST_LENGTH * 2;
+    #define MD5_Init            CC_MD5_Init
+    #define MD5_Update          CC_MD5_Update
+    #define MD5_Final           CC_MD5_Final
+    #define MD5_DIGEST_LENGTH   CC_MD5_DIGEST_LENGTH
+    #define MD5_CTX             CC_MD5_CTX
     
-    fseek( fp, offset, SEEK_SET );
+#else
     
-    __percent = 100;
-    
-    libprogressbar_end();
+    #include <openssl/md5.h>
+
+#endif
+
+#ifndef _EGZ_CHECKSUM_H_
+#define _EGZ_CHECKSUM_H_
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+    /* Declared in types.h, as the MD5 context type is only known here */
+    struct _egz_digest
+    {
+        unsigned int    type;
+        MD5_CTX         ctx;
+        uint32_t        crc;
+        uint64_t        state[ 4 ];
+        unsigned char   buffer[ 32 ];
+        size_t          buffered;
+        uint64_t        length;
+        unsigned int    stage;
+    };
+
+    /*!
+     * 
+     */
+    void egz_digest_init( egz_digest * digest, unsigned int type );
+
+    /*!
+     * 
+     */
+    void egz_digest_update( egz_digest * digest, unsigned char * data, size_t length );
+
+    /*!
+     * 
+     */
+    void egz_digest_final( egz_digest * digest, char * hash );
+
+    /*!
+     * 
+     */
+    void egz_md5_digest_to_hex( unsigned char * digest, char * hash );
+
+    /*!
+     * 
+     */
+    uint32_t egz_crc32c( uint32_t crc, unsigned char * data, size_t length );
+
+    /*!
+     * 
+     */
+    bool egz_get_checksum_type( char * name, unsigned int * type );
+
+    /*!
+     * 
+     */
+    const char * egz_get_checksum_name( unsigned int type );
+
+#ifdef __cplusplus
 }
+#endif
+
+#endif /* _EGZ_CHECKSUM_H_ */
@@ -48,7 +48,17 @@ extern "C" {
     /*!
      * 
      */
-    egz_status egz_compress( FILE * source, FILE * destination, bool force );
+    egz_status egz_compress( FILE * source, FILE * destination, egz_options * options );
+
+    /*!
+     * 
+     */
+    egz_status egz_compress_streamed( FILE * source, FILE * destination, egz_options * options );
+
+    /*!
+     * 
+     */
+    egz_status egz_compress_trained( FILE * source, FILE * destination, egz_options * options );
 
     /*!
      *
@@ -56,9 +66,14 @@ extern "C" {
     uint16_t egz_get_header_size( egz_table * table );
 
     /*!
-     * 
+     *
+     */
+    uint16_t egz_get_lengths_size( egz_table * table );
+
+    /*!
+     *
      */
-    egz_status egz_check_compression_ratio( egz_table * table );
+    void egz_pack_lengths( egz_table * table, unsigned char * buffer );
 
     /*!
      * 
@@ -68,12 +83,17 @@ extern "C" {
     /*!
      * 
      */
-    egz_status egz_write_header( FILE * source, FILE * destination, egz_table * table );
+    egz_status egz_write_header( FILE * source, FILE * destination, egz_table * table, uint8_t flags, char * md5 );
+
+    /*!
+     * 
+     */
+    size_t egz_pack_header( egz_table * table, uint8_t flags, uint64_t file_size, char * md5, unsigned char * buffer );
 
     /*!
      * 
      */
-    egz_status egz_write_compressed_file( FILE * source, FILE * destination, egz_table * table );
+    egz_status egz_write_compressed_blocks( FILE * source, FILE * destination, egz_table * table, egz_mapping * mapping, egz_digest * digest, egz_options * options );
 
 #ifdef __cplusplus
 }
@@ -45,12 +45,99 @@ extern "C" {
 
 #define EGZ_VERSION                 "0.0.0"
 #define EGZ_FILE_ID                 "EGZ"
-#define EGZ_FILE_HEADER_ID          "HDR"
+#define EGZ_FILE_HEADER_ID          "HD2"
+#define EGZ_FILE_HEADER_V1_ID       "HDR"
+#define EGZ_FILE_BATCH_ID           "BAT"
 #define EGZ_FILE_DATA_ID            "DAT"
 #define EGZ_FILE_EXT                ".egz"
+#define EGZ_ARCHIVE_ID              "EGA"
+#define EGZ_ARCHIVE_INDEX_ID        "IDX"
+#define EGZ_ARCHIVE_TRAILER_LENGTH  ( 3 + 8 + 4 + 4 )
+#define EGZ_ARCHIVE_ENTRY_MIN_LENGTH ( 2 + 1 + 8 + 8 + 8 + 1 + EGZ_CHECKSUM_LENGTH )
+#define EGZ_TABLE_FILE_ID           "EGT"
+#define EGZ_TABLE_FILE_EXT          ".egzt"
+#define EGZ_TABLE_FILE_MAX_LENGTH   ( 3 + 8 + 2 + 256 )
+#define EGZ_TABLE_PATH_ENV          "EGZ_TABLE_PATH"
+#define EGZ_TABLE_PATH_DEFAULT      "."
+#define EGZ_HEADER_PREFIX_LENGTH    8
+#define EGZ_HEADER_MAX_LENGTH       ( EGZ_HEADER_PREFIX_LENGTH + 42 + 2 + 256 )
 #define EGZ_BTREE_CODE_MAX_LENGTH   64
 #define EGZ_READ_BUFFER_LENGTH      1024
+#define EGZ_MAP_CHUNK_LENGTH        ( 1024 * 1024 )
 #define EGZ_WRITE_BUFFER_LENGTH     1024
+#define EGZ_LOOKUP_BITS             12
+#define EGZ_HISTOGRAM_LANES         4
+#define EGZ_HISTOGRAM_FLUSH_LENGTH  ( 1024 * 1024 * 1024 )
+#define EGZ_MAX_CODE_BITS_DEFAULT   12
+#define EGZ_MAX_CODE_BITS_MIN       8
+#define EGZ_HEADER_LENGTHS_PAIRS    128
+#define EGZ_HEADER_FLAG_STREAMS     0x01
+#define EGZ_HEADER_FLAG_BLOCKS      0x02
+#define EGZ_HEADER_FLAG_STREAMED    0x04
+#define EGZ_HEADER_FLAG_TABLE_ID    0x08
+#define EGZ_HEADER_CHECKSUM_MASK    0x30
+#define EGZ_HEADER_CHECKSUM_SHIFT   4
+#define EGZ_HEADER_FLAG_CHECKSUM( type ) ( ( uint8_t )( ( type ) << EGZ_HEADER_CHECKSUM_SHIFT ) )
+#define EGZ_CHECKSUM_MD5            0
+#define EGZ_CHECKSUM_CRC32C         1
+#define EGZ_CHECKSUM_XXH64          2
+#define EGZ_CHECKSUM_NONE           3
+#define EGZ_CHECKSUM_DEFAULT        EGZ_CHECKSUM_XXH64
+#define EGZ_CHECKSUM_LENGTH         33
+#define EGZ_CRC32C_POLYNOMIAL       0x82F63B78
+#define EGZ_STDIO_NAME              "-"
+#define EGZ_BLOCK_HEADER_LENGTH     10
+#define EGZ_BLOCK_FLAG_TABLE        0x01
+#define EGZ_BLOCK_FLAG_STORED       0x02
+#define EGZ_BLOCK_FLAG_CHECKSUM     0x04
+#define EGZ_TRAILER_LENGTH          ( 8 + EGZ_CHECKSUM_LENGTH )
+#define EGZ_BATCH_PREFIX_MAX_LENGTH 10
+#define EGZ_BLOCK_SIZE_DEFAULT      ( 1024 * 1024 )
+#define EGZ_BLOCK_SIZE_MIN          ( 64 * 1024 )
+#define EGZ_BLOCK_SIZE_MAX          ( 4096 * 1024 )
+#define EGZ_SPLIT_SEGMENT_LENGTH    ( 16 * 1024 )
+#define EGZ_THREADS_DEFAULT         1
+#define EGZ_THREADS_MAX             256
+#define EGZ_JOB_FREE                0
+#define EGZ_JOB_READY               1
+#define EGZ_JOB_RUNNING             2
+#define EGZ_JOB_DONE                3
+#define EGZ_STREAMS_DEFAULT         4
+#define EGZ_STREAMS_MAX             16
+#define EGZ_STREAMS_MIN_SIZE        8192
+#define EGZ_STATS_FORMAT_TEXT       1
+#define EGZ_STATS_FORMAT_JSON       2
+#define EGZ_STATS_HISTOGRAM         0
+#define EGZ_STATS_TREE              1
+#define EGZ_STATS_CODES             2
+#define EGZ_STATS_HEADER            3
+#define EGZ_STATS_ENCODE            4
+#define EGZ_STATS_CHECKSUM          5
+#define EGZ_STATS_PARSE             6
+#define EGZ_STATS_REBUILD           7
+#define EGZ_STATS_DECODE            8
+#define EGZ_STATS_VERIFY            9
+#define EGZ_STATS_STAGES            10
+#define EGZ_TRACE_LEVEL_NONE        0
+#define EGZ_TRACE_LEVEL_BLOCK       1
+#define EGZ_TRACE_LEVEL_SYMBOL      2
+#define EGZ_TRACE_BUFFER_LENGTH     4096
+#define EGZ_TRACE_BLOCK_COMPRESSED  0
+#define EGZ_TRACE_BLOCK_EXPANDED    1
+#define EGZ_TRACE_BLOCK_CODES       2
+#define EGZ_TRACE_BLOCK_STORED      3
+#define EGZ_TRACE_TREE_SYMBOL       4
+#define EGZ_TRACE_TREE_BRANCH       5
+#define EGZ_TRACE_TREE_NODE         6
+#define EGZ_TRACE_TREE_LEAF         7
+#define EGZ_TRACE_EVENTS            8
+#define EGZ_PROGRESS_ANALYZE        0
+#define EGZ_PROGRESS_COMPRESS       1
+#define EGZ_PROGRESS_EXPAND         2
+#define EGZ_PROGRESS_FILES          3
+#define EGZ_PROGRESS_STAGES         4
+#define EGZ_PROGRESS_INTERVAL       0.25
+#define EGZ_PROGRESS_LINE_LENGTH    256
 
 #ifdef __cplusplus
 }
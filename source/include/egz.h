@@ -58,16 +58,29 @@ extern "C" {
 #include "constants.h"
 #include "macros.h"
 #include "types.h"
+#include "archive.h"
 #include "args.h"
+#include "batch.h"
+#include "bitstream.h"
+#include "block.h"
+#include "buffer.h"
 #include "btree.h"
+#include "checksum.h"
 #include "compress.h"
 #include "debug.h"
 #include "error.h"
 #include "expand.h"
 #include "file.h"
+#include "files.h"
 #include "help.h"
-#include "md5.h"
+#include "lookup.h"
+#include "pool.h"
+#include "progress.h"
+#include "scheduler.h"
+#include "stats.h"
 #include "symbols.h"
+#include "table.h"
+#include "trace.h"
 
 #ifdef __cplusplus
 }
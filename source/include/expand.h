@@ -48,7 +48,17 @@ extern "C" {
     /*!
      * 
      */
-    egz_status egz_expand( FILE * source, FILE * destination );
+    egz_status egz_expand( FILE * source, FILE * destination, egz_options * options );
+
+    /*!
+     * 
+     */
+    egz_status egz_read_header( unsigned char * data, size_t length, egz_header * header );
+
+    /*!
+     * 
+     */
+    unsigned int egz_rebuild_lengths( unsigned char * data, unsigned char * lengths, uint16_t length );
 
     /*!
      * 
@@ -63,12 +73,22 @@ extern "C" {
     /*!
      * 
      */
-    egz_status egz_write_expanded_file( FILE * source, FILE * destination, egz_symbol * tree, uint64_t filesize  );
+    egz_status egz_write_expanded_file( FILE * source, FILE * destination, egz_lookup * lookup, uint64_t filesize, egz_digest * digest );
+    
+    /*!
+     * 
+     */
+    egz_status egz_write_expanded_streams( FILE * source, FILE * destination, egz_lookup * lookup, uint64_t filesize, egz_digest * digest );
+    
+    /*!
+     * 
+     */
+    egz_status egz_write_expanded_blocks( FILE * source, FILE * destination, egz_lookup * lookup, uint8_t flags, uint64_t filesize, unsigned char * checksum, egz_options * options );
     
     /*!
      * 
      */
-    egz_status egz_verify_checksum( FILE * destination, unsigned char * checksum );
+    egz_status egz_verify_checksum( egz_digest * digest, unsigned char * checksum );
 
 #ifdef __cplusplus
 }
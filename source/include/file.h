@@ -48,7 +48,7 @@ extern "C" {
     /*!
      * 
      */
-    bool egz_get_destination_filename( char * source, char * filename, bool compress );
+    bool egz_get_destination_filename( char * source, char * filename, bool compress, bool in_place );
 
     /*!
      * 
@@ -60,6 +60,16 @@ extern "C" {
      */
     double egz_getfilesize_human( FILE * fp, char * unit );
 
+    /*!
+     * 
+     */
+    bool egz_map_file( FILE * fp, egz_mapping * mapping );
+
+    /*!
+     * 
+     */
+    void egz_unmap_file( egz_mapping * mapping );
+
 #ifdef __cplusplus
 }
 #endif
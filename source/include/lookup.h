@@ -0,0 +1,94 @@
+/*******************************************************************************
+ * Copyright (c) 2010, Jean-David Gadina - www.xs-labs.com
+ * Distributed under the Boost Software License, Version 1.0.
+ * 
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ * 
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ * 
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ******************************************************************************/
+
+/* $Id$ */
+
+/*!
+ * @header      lookup.h
+ * @copyright   (c) 2011 - Jean-David Gadina - www.xs-labs.com
+ * @abstract    Lookup table functions
+ */
+
+#ifndef _EGZ_LOOKUP_H_
+#define _EGZ_LOOKUP_H_
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "types.h"
+
+/*!
+ * @define      EGZ_LOOKUP_DECODE
+ * @abstract    Decodes the symbol at the start of a 64 bits window
+ * @param       LOOKUP      The lookup table
+ * @param       WINDOW      The next 64 bits of the bitstream
+ * @param       CHARACTER   The decoded character
+ * @param       BITS        The length of the decoded code (0 if the code is invalid)
+ */
+#define EGZ_LOOKUP_DECODE( LOOKUP, WINDOW, CHARACTER, BITS )                            \
+    do                                                                                  \
+    {                                                                                   \
+        egz_lookup_entry * _entry;                                                      \
+                                                                                        \
+        _entry = &( ( LOOKUP )->entries[ ( WINDOW ) >> ( 64 - EGZ_LOOKUP_BITS ) ] );    \
+                                                                                        \
+        if( _entry->bits > 0 )                                                          \
+        {                                                                               \
+            ( CHARACTER ) = _entry->character;                                          \
+            ( BITS )      = _entry->bits;                                               \
+        }                                                                               \
+        else                                                                            \
+        {                                                                               \
+            ( BITS ) = egz_lookup_decode_long( LOOKUP, WINDOW, &( CHARACTER ) );        \
+        }                                                                               \
+    }                                                                                   \
+    while( 0 )
+
+    /*!
+     * 
+     */
+    egz_lookup * egz_create_lookup( egz_symbol * tree );
+
+    /*!
+     * 
+     */
+    egz_status egz_create_canonical_lookup( egz_lookup ** lookup_ptr, unsigned char * lengths );
+
+    /*!
+     * 
+     */
+    unsigned int egz_lookup_decode_long( egz_lookup * lookup, uint64_t window, unsigned char * character );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _EGZ_LOOKUP_H_ */
@@ -30,49 +30,58 @@
 /* $Id$ */
 
 /*!
- * @header      md5.h
+ * @header      progress.h
  * @copyright   (c) 2011 - Jean-David Gadina - www.xs-labs.com
- * @abstract    MD5 functions
+ * @abstract    Progress of the current stage
  */
 
-/* System includes */
-#if defined( __APPLE__ )
-    
-    #include <CommonCrypto/CommonDigest.h>
-    
-    #ifdef MD5_DIGEST_LENGTH
-        
-        #undef MD5_DIGEST_LENGTH
-        
-    #endif
-    
-    #define MD5_Init            CC_MD5_Init
-    #define MD5_Update          CC_MD5_Update
-    #define MD5_Final           CC_MD5_Final
-    #define MD5_DIGEST_LENGTH   CC_MD5_DIGEST_LENGTH
-    #define MD5_CTX             CC_MD5_CTX
-    
-#else
-    
-    #include <openssl/md5.h>
-
-#endif
-
-#ifndef _EGZ_MD5_H_
-#define _EGZ_MD5_H_
+#ifndef _EGZ_PROGRESS_H_
+#define _EGZ_PROGRESS_H_
 #pragma once
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+#include "types.h"
+
+    /*!
+     * 
+     */
+    void egz_progress_init( void );
+
+    /*!
+     * 
+     */
+    bool egz_progress_open( int fd );
+
+    /*!
+     * 
+     */
+    bool egz_progress_is_enabled( void );
+
+    /*!
+     * 
+     */
+    void egz_progress_begin( unsigned int stage, uint64_t total );
+
+    /*!
+     * 
+     */
+    void egz_progress_update( uint64_t done );
+
+    /*!
+     * 
+     */
+    void egz_progress_end( void );
+
     /*!
      * 
      */
-    void egz_file_md5_checksum( FILE * fp, char * hash );
+    bool egz_get_progress_fd( char * value, int * fd );
 
 #ifdef __cplusplus
 }
 #endif
 
-#endif /* _EGZ_MD5_H_ */
+#endif /* _EGZ_PROGRESS_H_ */
@@ -53,7 +53,32 @@ extern "C" {
     /*!
      * 
      */
-    void egz_get_symbols( egz_table * table, FILE * source );
+    void egz_get_symbols( egz_table * table, FILE * source, egz_mapping * mapping, egz_digest * digest );
+
+    /*!
+     * 
+     */
+    void egz_count_symbols( egz_table * table, unsigned char * data, size_t length );
+
+    /*!
+     * 
+     */
+    void egz_histogram_begin( egz_histogram * histogram );
+
+    /*!
+     * 
+     */
+    void egz_histogram_update( egz_histogram * histogram, unsigned char * data, size_t length );
+
+    /*!
+     * 
+     */
+    void egz_histogram_end( egz_histogram * histogram, egz_table * table );
+
+    /*!
+     * 
+     */
+    void egz_count_histogram( unsigned long * histogram, unsigned char * data, size_t length );
 
     /*!
      * 
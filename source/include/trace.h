@@ -0,0 +1,99 @@
+/*******************************************************************************
+ * Copyright (c) 2010, Jean-David Gadina - www.xs-labs.com
+ * Distributed under the Boost Software License, Version 1.0.
+ * 
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ * 
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ * 
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ******************************************************************************/
+
+/* $Id$ */
+
+/*!
+ * @header      trace.h
+ * @copyright   (c) 2011 - Jean-David Gadina - www.xs-labs.com
+ * @abstract    Compile-time trace events
+ * @description The trace level is chosen when building (-DEGZ_TRACE_LEVEL=N,
+ *              or "make TRACE=N"). Events above that level are removed by the
+ *              preprocessor, so release builds have no trace code in the
+ *              compression and expansion loops. The recorded events are kept
+ *              in a ring buffer, which is dumped on demand.
+ */
+
+#ifndef _EGZ_TRACE_H_
+#define _EGZ_TRACE_H_
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "types.h"
+
+#ifndef EGZ_TRACE_LEVEL
+#define EGZ_TRACE_LEVEL EGZ_TRACE_LEVEL_NONE
+#endif
+
+/*!
+ * @define      EGZ_TRACE_BLOCK
+ * @abstract    Records an event that happens once per block
+ * @param       EVENT   The event type
+ * @param       A       First argument
+ * @param       B       Second argument
+ * @param       C       Third argument
+ */
+#if EGZ_TRACE_LEVEL >= EGZ_TRACE_LEVEL_BLOCK
+#define EGZ_TRACE_BLOCK( EVENT, A, B, C ) egz_trace_record( EVENT, __FILE__, __LINE__, ( uint64_t )( A ), ( uint64_t )( B ), ( uint64_t )( C ) )
+#else
+#define EGZ_TRACE_BLOCK( EVENT, A, B, C )
+#endif
+
+/*!
+ * @define      EGZ_TRACE_SYMBOL
+ * @abstract    Records an event that happens once per symbol, code bit or tree node
+ * @param       EVENT   The event type
+ * @param       A       First argument
+ * @param       B       Second argument
+ * @param       C       Third argument
+ */
+#if EGZ_TRACE_LEVEL >= EGZ_TRACE_LEVEL_SYMBOL
+#define EGZ_TRACE_SYMBOL( EVENT, A, B, C ) egz_trace_record( EVENT, __FILE__, __LINE__, ( uint64_t )( A ), ( uint64_t )( B ), ( uint64_t )( C ) )
+#else
+#define EGZ_TRACE_SYMBOL( EVENT, A, B, C )
+#endif
+
+    /*!
+     * 
+     */
+    void egz_trace_record( unsigned int event, const char * file, unsigned int line, uint64_t a, uint64_t b, uint64_t c );
+
+    /*!
+     * 
+     */
+    unsigned long egz_trace_dump( FILE * stream );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _EGZ_TRACE_H_ */
@@ -52,21 +52,57 @@ extern "C" {
         EGZ_ERROR_INVALID_CHECKSUM  = 0x004,
         EGZ_ERROR_ABORT             = 0x005,
         EGZ_ERROR_INVALID_TREE      = 0x006,
+        EGZ_ERROR_BUFFER_TOO_SMALL  = 0x007,
+        EGZ_ERROR_INVALID_INDEX     = 0x008,
+        EGZ_ERROR_TABLE_NOT_FOUND   = 0x009,
+        EGZ_ERROR_FILE              = 0x00A,
         EGZ_ERROR_UNKNOWN           = 0x666
     }
     egz_status;
 
     typedef struct _egz_cli_args
     {
-        bool   compress;
-        bool   expand;
-        bool   force;
-        bool   version;
-        bool   help;
-        bool   debug;
-        char * source;
+        bool         compress;
+        bool         expand;
+        bool         force;
+        bool         version;
+        bool         help;
+        bool         debug;
+        unsigned int max_code_bits;
+        unsigned int streams;
+        unsigned int block_size;
+        unsigned int threads;
+        bool         to_stdout;
+        bool         train;
+        bool         adaptive;
+        bool         recursive;
+        bool         list;
+        char       * output;
+        char       * table;
+        char       * check;
+        char       * stats;
+        char       * progress_fd;
+        char       * files_from;
+        char       * archive;
+        char       * source;
+        char      ** sources;
+        unsigned int source_count;
     }
     egz_cli_args;
+    
+    typedef struct _egz_options
+    {
+        unsigned int max_code_bits;
+        unsigned int streams;
+        unsigned int block_size;
+        unsigned int threads;
+        bool         streamed;
+        bool         adaptive;
+        bool         quiet;
+        unsigned int checksum_type;
+        char       * table_file;
+    }
+    egz_options;
 
     typedef struct _egz_symbol
     {
@@ -87,12 +123,282 @@ extern "C" {
     typedef struct _egz_table
     {
         egz_symbol     symbols[ 256 ];
+        uint64_t       id;
         unsigned int   count;
         unsigned long  total;
         double         information;
         double         entropy;
     }
     egz_table;
+    
+    typedef struct _egz_histogram
+    {
+        uint32_t        lanes[ EGZ_HISTOGRAM_LANES ][ 256 ];
+        unsigned long   counts[ 256 ];
+        size_t          pending;
+    }
+    egz_histogram;
+    
+    typedef struct _egz_lookup_entry
+    {
+        unsigned char character;
+        unsigned char bits;
+    }
+    egz_lookup_entry;
+    
+    typedef struct _egz_lookup
+    {
+        egz_lookup_entry   entries[ 1 << EGZ_LOOKUP_BITS ];
+        egz_symbol       * tree;
+        unsigned int       max_bits;
+        unsigned int       counts[ EGZ_BTREE_CODE_MAX_LENGTH + 1 ];
+        unsigned int       offsets[ EGZ_BTREE_CODE_MAX_LENGTH + 1 ];
+        uint64_t           first[ EGZ_BTREE_CODE_MAX_LENGTH + 1 ];
+        unsigned char      symbols[ 256 ];
+    }
+    egz_lookup;
+    
+    typedef struct _egz_bitreader
+    {
+        FILE          * source;
+        unsigned char * data;
+        uint64_t        buffer[ EGZ_READ_BUFFER_LENGTH ];
+        size_t          length;
+        size_t          index;
+        uint64_t        current;
+        uint64_t        next;
+        unsigned int    position;
+    }
+    egz_bitreader;
+    
+    typedef struct _egz_bitwriter
+    {
+        uint64_t     * words;
+        size_t         length;
+        size_t         capacity;
+        uint64_t       current;
+        unsigned int   bits;
+    }
+    egz_bitwriter;
+    
+    typedef struct _egz_block
+    {
+        unsigned char * data;
+        size_t          length;
+        size_t          capacity;
+    }
+    egz_block;
+    
+    typedef struct _egz_context
+    {
+        egz_options     options;
+        egz_block       block;
+    }
+    egz_context;
+    
+    typedef struct _egz_batch
+    {
+        unsigned char * data;
+        unsigned char * end;
+        size_t          count;
+        size_t          index;
+        unsigned char * position;
+        egz_lookup    * lookup;
+        egz_block       words;
+    }
+    egz_batch;
+    
+    typedef struct _egz_mapping
+    {
+        unsigned char * data;
+        size_t          length;
+    }
+    egz_mapping;
+    
+    typedef struct _egz_digest egz_digest;
+    
+    typedef struct _egz_header
+    {
+        bool            v1;
+        uint8_t         flags;
+        size_t          length;
+        uint64_t        original_length;
+        unsigned char * checksum;
+        unsigned char * symbols;
+        uint16_t        symbols_length;
+        uint64_t        table_id;
+        unsigned int    checksum_type;
+    }
+    egz_header;
+    
+    typedef struct _egz_block_header
+    {
+        uint8_t         flags;
+        unsigned int    streams;
+        uint32_t        original_length;
+        uint32_t        payload_length;
+    }
+    egz_block_header;
+    
+    typedef struct _egz_block_context
+    {
+        egz_table       * table;
+        egz_lookup      * lookup;
+        egz_options     * options;
+    }
+    egz_block_context;
+    
+    typedef struct _egz_job
+    {
+        unsigned char   * data;
+        size_t            length;
+        egz_block         input;
+        egz_block         output;
+        egz_status        status;
+        unsigned int      state;
+    }
+    egz_job;
+    
+    typedef struct _egz_timer
+    {
+        double          wall;
+        double          cpu;
+        double          nested_wall;
+        double          nested_cpu;
+    }
+    egz_timer;
+    
+    typedef struct _egz_stage
+    {
+        double          wall;
+        double          cpu;
+        uint64_t        bytes_in;
+        uint64_t        bytes_out;
+        unsigned long   calls;
+    }
+    egz_stage;
+    
+    typedef struct _egz_trace_event
+    {
+        uint64_t        sequence;
+        const char    * file;
+        unsigned int    line;
+        unsigned int    event;
+        uint64_t        args[ 3 ];
+    }
+    egz_trace_event;
+    
+    typedef struct _egz_task
+    {
+        char            * path;
+        char            * destination;
+        uint64_t          size;
+        uint64_t          output_size;
+        unsigned char   * output;
+        egz_status        status;
+    }
+    egz_task;
+    
+    typedef struct _egz_files
+    {
+        egz_task        * tasks;
+        size_t            count;
+        size_t            capacity;
+        unsigned long     errors;
+    }
+    egz_files;
+    
+    typedef struct _egz_files_context
+    {
+        egz_options       options;
+        bool              compress;
+        pthread_mutex_t   mutex;
+    }
+    egz_files_context;
+    
+    typedef struct _egz_archive_entry
+    {
+        char            * name;
+        uint64_t          original_length;
+        uint64_t          offset;
+        uint64_t          length;
+        unsigned int      checksum_type;
+        char              checksum[ EGZ_CHECKSUM_LENGTH ];
+    }
+    egz_archive_entry;
+    
+    typedef struct _egz_archive
+    {
+        FILE              * fp;
+        egz_archive_entry * entries;
+        uint32_t            count;
+    }
+    egz_archive;
+    
+    typedef struct _egz_archive_context
+    {
+        egz_options       options;
+        dev_t             device;
+        ino_t             inode;
+    }
+    egz_archive_context;
+    
+    typedef egz_status ( * egz_pool_function )( egz_job * job, void * context );
+    
+    typedef egz_status ( * egz_task_function )( egz_task * task, void * context );
+    
+    typedef struct _egz_pool
+    {
+        pthread_t         * threads;
+        unsigned int        thread_count;
+        egz_job           * jobs;
+        unsigned int        job_count;
+        unsigned long       next_submit;
+        unsigned long       next_work;
+        unsigned long       next_collect;
+        bool                stop;
+        pthread_mutex_t     mutex;
+        pthread_cond_t      work;
+        pthread_cond_t      done;
+        egz_pool_function   function;
+        void              * context;
+    }
+    egz_pool;
+    
+    typedef struct _egz_deque
+    {
+        egz_task       ** tasks;
+        size_t            head;
+        size_t            tail;
+        pthread_mutex_t   mutex;
+    }
+    egz_deque;
+    
+    typedef struct _egz_worker
+    {
+        pthread_t                 thread;
+        bool                      running;
+        unsigned int              index;
+        egz_deque                 deque;
+        struct _egz_scheduler   * scheduler;
+    }
+    egz_worker;
+    
+    typedef struct _egz_scheduler
+    {
+        egz_worker        * workers;
+        unsigned int        worker_count;
+        egz_task         ** order;
+        egz_task         ** completed;
+        size_t              task_count;
+        size_t              completed_count;
+        size_t              collected;
+        pthread_mutex_t     mutex;
+        pthread_cond_t      done;
+        egz_task_function   function;
+        void              * context;
+    }
+    egz_scheduler;
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,246 @@
+/*******************************************************************************
+ * Copyright (c) 2010, Jean-David Gadina - www.xs-labs.com
+ * Distributed under the Boost Software License, Version 1.0.
+ * 
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ * 
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ * 
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ******************************************************************************/
+
+/* $Id$ */
+
+/*!
+ * @file        lookup.c
+ * @copyright   (c) 2011 - Jean-David Gadina - www.xs-labs.com
+ * @abstract    Lookup table functions
+ */
+
+/* Local includes */
+#include "egz.h"
+
+/* Private functions */
+static void egz_fill_lookup( egz_lookup * lookup, egz_symbol * node, unsigned int depth, unsigned int prefix );
+
+/*!
+ * 
+ */
+egz_lookup * egz_create_lookup( egz_symbol * tree )
+{
+    egz_lookup * lookup;
+    
+    /* Allocates memory for the lookup table */
+    if( NULL == ( lookup = ( egz_lookup * )malloc( sizeof( egz_lookup ) ) ) )
+    {
+        return NULL;
+    }
+    
+    lookup->tree     = tree;
+    lookup->max_bits = 0;
+    
+    /* Fills the table entries by walking the tree */
+    egz_fill_lookup( lookup, tree, 0, 0 );
+    
+    return lookup;
+}
+
+/*!
+ * 
+ */
+egz_status egz_create_canonical_lookup( egz_lookup ** lookup_ptr, unsigned char * lengths )
+{
+    unsigned int  i;
+    unsigned int  j;
+    unsigned int  bits;
+    unsigned int  first;
+    unsigned int  count;
+    unsigned int  positions[ EGZ_BTREE_CODE_MAX_LENGTH + 1 ];
+    uint64_t      code;
+    egz_lookup  * lookup;
+    
+    /* Allocates memory for the lookup table */
+    if( NULL == ( lookup = ( egz_lookup * )calloc( 1, sizeof( egz_lookup ) ) ) )
+    {
+        return EGZ_ERROR_MALLOC;
+    }
+    
+    lookup->tree     = NULL;
+    lookup->max_bits = 0;
+    
+    /* Counts the number of codes for each length */
+    for( i = 0; i < 256; i++ )
+    {
+        if( lengths[ i ] > EGZ_BTREE_CODE_MAX_LENGTH )
+        {
+            free( lookup );
+            return EGZ_ERROR_INVALID_TREE;
+        }
+        
+        lookup->counts[ lengths[ i ] ]++;
+        
+        if( lengths[ i ] > lookup->max_bits )
+        {
+            lookup->max_bits = lengths[ i ];
+        }
+    }
+    
+    lookup->counts[ 0 ] = 0;
+    code                = 0;
+    
+    /* First code and position in the sorted symbols of each length */
+    for( bits = 1; bits <= EGZ_BTREE_CODE_MAX_LENGTH; bits++ )
+    {
+        code                    = ( code + lookup->counts[ bits - 1 ] ) << 1;
+        lookup->first[ bits ]   = code;
+        lookup->offsets[ bits ] = lookup->offsets[ bits - 1 ] + lookup->counts[ bits - 1 ];
+        
+        /* More codes than the length allows - Not a prefix code */
+        if( bits < EGZ_BTREE_CODE_MAX_LENGTH && code + lookup->counts[ bits ] > ( ( uint64_t )1 << bits ) )
+        {
+            free( lookup );
+            return EGZ_ERROR_INVALID_TREE;
+        }
+    }
+    
+    /* No symbol at all */
+    if( lookup->max_bits == 0 )
+    {
+        free( lookup );
+        return EGZ_ERROR_INVALID_TREE;
+    }
+    
+    memcpy( positions, lookup->offsets, sizeof( positions ) );
+    
+    /* Sorts the symbols by code length (counting sort, stable on the symbol value) */
+    for( i = 0; i < 256; i++ )
+    {
+        if( lengths[ i ] > 0 )
+        {
+            lookup->symbols[ positions[ lengths[ i ] ]++ ] = ( unsigned char )i;
+        }
+    }
+    
+    /* Fills the table entries for the codes fitting the table index */
+    for( bits = 1; bits <= lookup->max_bits && bits <= EGZ_LOOKUP_BITS; bits++ )
+    {
+        for( j = 0; j < lookup->counts[ bits ]; j++ )
+        {
+            first = ( unsigned int )( lookup->first[ bits ] + j ) << ( EGZ_LOOKUP_BITS - bits );
+            count = 1 << ( EGZ_LOOKUP_BITS - bits );
+            
+            for( i = first; i < first + count; i++ )
+            {
+                lookup->entries[ i ].character = lookup->symbols[ lookup->offsets[ bits ] + j ];
+                lookup->entries[ i ].bits      = ( unsigned char )bits;
+            }
+        }
+    }
+    
+    *( lookup_ptr ) = lookup;
+    
+    return EGZ_OK;
+}
+
+/*!
+ * 
+ */
+unsigned int egz_lookup_decode_long( egz_lookup * lookup, uint64_t window, unsigned char * character )
+{
+    unsigned int bits;
+    uint64_t     code;
+    egz_symbol * node;
+    
+    /* Canonical codes - Checks each length above the table index */
+    if( lookup->tree == NULL )
+    {
+        for( bits = EGZ_LOOKUP_BITS + 1; bits <= lookup->max_bits; bits++ )
+        {
+            code = ( window >> ( 64 - bits ) ) - lookup->first[ bits ];
+            
+            if( code < lookup->counts[ bits ] )
+            {
+                *( character ) = lookup->symbols[ lookup->offsets[ bits ] + code ];
+                
+                return bits;
+            }
+        }
+        
+        return 0;
+    }
+    
+    bits = 0;
+    node = lookup->tree;
+    
+    /* Walks the tree with the window bits, until a leaf is found */
+    while( node->left != NULL && node->right != NULL )
+    {
+        /* Codes cannot be longer than the window */
+        if( bits == EGZ_BTREE_CODE_MAX_LENGTH )
+        {
+            return 0;
+        }
+        
+        node = ( ( window >> ( 63 - bits ) ) & 1 ) ? node->right : node->left;
+        
+        bits++;
+    }
+    
+    *( character ) = node->character;
+    
+    return bits;
+}
+
+/*!
+ * 
+ */
+static void egz_fill_lookup( egz_lookup * lookup, egz_symbol * node, unsigned int depth, unsigned int prefix )
+{
+    unsigned int i;
+    unsigned int first;
+    unsigned int count;
+    
+    /* Checks if we have a leaf node */
+    if( node->left == NULL && node->right == NULL )
+    {
+        /* Leaf - Every index beginning with the code resolves to the symbol */
+        first = prefix << ( EGZ_LOOKUP_BITS - depth );
+        count = 1 << ( EGZ_LOOKUP_BITS - depth );
+        
+        for( i = first; i < first + count; i++ )
+        {
+            lookup->entries[ i ].character = node->character;
+            lookup->entries[ i ].bits      = ( unsigned char )depth;
+        }
+    }
+    else if( depth == EGZ_LOOKUP_BITS )
+    {
+        /* Code is longer than the table index - Marks the entry for the tree walk */
+        lookup->entries[ prefix ].character = 0;
+        lookup->entries[ prefix ].bits      = 0;
+    }
+    else
+    {
+        /* Node - Fills the entries for the left (0) and right (1) children */
+        egz_fill_lookup( lookup, node->left,  depth + 1, ( prefix << 1 ) );
+        egz_fill_lookup( lookup, node->right, depth + 1, ( prefix << 1 ) + 1 );
+    }
+}
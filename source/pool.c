@@ -0,0 +1,290 @@
+/*******************************************************************************
+ * Copyright (c) 2010, Jean-David Gadina - www.xs-labs.com
+ * Distributed under the Boost Software License, Version 1.0.
+ * 
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ * 
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ * 
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ******************************************************************************/
+
+/* $Id$ */
+
+/*!
+ * @file        pool.c
+ * @copyright   (c) 2011 - Jean-David Gadina - www.xs-labs.com
+ * @abstract    Worker pool functions
+ */
+
+/* Local includes */
+#include "egz.h"
+
+/* Private functions */
+static void * egz_pool_worker( void * pool_ptr );
+
+/*!
+ * 
+ */
+egz_pool * egz_pool_create( unsigned int threads, egz_pool_function function, void * context )
+{
+    unsigned int i;
+    egz_pool   * pool;
+    
+    if( NULL == ( pool = ( egz_pool * )calloc( 1, sizeof( egz_pool ) ) ) )
+    {
+        return NULL;
+    }
+    
+    /* Two jobs per thread, so the workers have something to do while the results are written */
+    pool->job_count = threads * 2;
+    pool->function  = function;
+    pool->context   = context;
+    
+    if( NULL == ( pool->jobs = ( egz_job * )calloc( pool->job_count, sizeof( egz_job ) ) ) )
+    {
+        free( pool );
+        return NULL;
+    }
+    
+    if( NULL == ( pool->threads = ( pthread_t * )calloc( threads, sizeof( pthread_t ) ) ) )
+    {
+        free( pool->jobs );
+        free( pool );
+        return NULL;
+    }
+    
+    for( i = 0; i < pool->job_count; i++ )
+    {
+        egz_block_init( &( pool->jobs[ i ].input ) );
+        egz_block_init( &( pool->jobs[ i ].output ) );
+        
+        pool->jobs[ i ].data   = NULL;
+        pool->jobs[ i ].length = 0;
+        pool->jobs[ i ].status = EGZ_OK;
+        pool->jobs[ i ].state  = EGZ_JOB_FREE;
+    }
+    
+    pthread_mutex_init( &( pool->mutex ), NULL );
+    pthread_cond_init( &( pool->work ), NULL );
+    pthread_cond_init( &( pool->done ), NULL );
+    
+    for( i = 0; i < threads; i++ )
+    {
+        if( pthread_create( &( pool->threads[ i ] ), NULL, egz_pool_worker, pool ) != 0 )
+        {
+            break;
+        }
+        
+        pool->thread_count++;
+    }
+    
+    /* No worker at all - Nothing would ever be processed */
+    if( pool->thread_count == 0 )
+    {
+        egz_pool_destroy( pool );
+        return NULL;
+    }
+    
+    return pool;
+}
+
+/*!
+ * 
+ */
+void egz_pool_destroy( egz_pool * pool )
+{
+    unsigned int i;
+    
+    pthread_mutex_lock( &( pool->mutex ) );
+    
+    pool->stop = true;
+    
+    pthread_cond_broadcast( &( pool->work ) );
+    pthread_mutex_unlock( &( pool->mutex ) );
+    
+    for( i = 0; i < pool->thread_count; i++ )
+    {
+        pthread_join( pool->threads[ i ], NULL );
+    }
+    
+    for( i = 0; i < pool->job_count; i++ )
+    {
+        egz_block_free( &( pool->jobs[ i ].input ) );
+        egz_block_free( &( pool->jobs[ i ].output ) );
+    }
+    
+    pthread_mutex_destroy( &( pool->mutex ) );
+    pthread_cond_destroy( &( pool->work ) );
+    pthread_cond_destroy( &( pool->done ) );
+    
+    free( pool->threads );
+    free( pool->jobs );
+    free( pool );
+}
+
+/*!
+ * 
+ */
+egz_job * egz_pool_acquire( egz_pool * pool )
+{
+    egz_job * job;
+    
+    job = NULL;
+    
+    pthread_mutex_lock( &( pool->mutex ) );
+    
+    /* Jobs are used in order - The next one is free once its result was collected */
+    if( pool->next_submit - pool->next_collect < pool->job_count )
+    {
+        job = &( pool->jobs[ pool->next_submit % pool->job_count ] );
+    }
+    
+    pthread_mutex_unlock( &( pool->mutex ) );
+    
+    return job;
+}
+
+/*!
+ * 
+ */
+void egz_pool_submit( egz_pool * pool, egz_job * job )
+{
+    pthread_mutex_lock( &( pool->mutex ) );
+    
+    job->status = EGZ_OK;
+    job->state  = EGZ_JOB_READY;
+    
+    pool->next_submit++;
+    
+    pthread_cond_signal( &( pool->work ) );
+    pthread_mutex_unlock( &( pool->mutex ) );
+}
+
+/*!
+ * 
+ */
+egz_job * egz_pool_collect( egz_pool * pool )
+{
+    egz_job * job;
+    
+    pthread_mutex_lock( &( pool->mutex ) );
+    
+    /* Nothing was submitted */
+    if( pool->next_collect == pool->next_submit )
+    {
+        pthread_mutex_unlock( &( pool->mutex ) );
+        
+        return NULL;
+    }
+    
+    /* Results are collected in the submission order */
+    job = &( pool->jobs[ pool->next_collect % pool->job_count ] );
+    
+    while( job->state != EGZ_JOB_DONE )
+    {
+        pthread_cond_wait( &( pool->done ), &( pool->mutex ) );
+    }
+    
+    pthread_mutex_unlock( &( pool->mutex ) );
+    
+    return job;
+}
+
+/*!
+ * 
+ */
+void egz_pool_release( egz_pool * pool, egz_job * job )
+{
+    pthread_mutex_lock( &( pool->mutex ) );
+    
+    job->state = EGZ_JOB_FREE;
+    
+    pool->next_collect++;
+    
+    pthread_mutex_unlock( &( pool->mutex ) );
+}
+
+/*!
+ * 
+ */
+unsigned int egz_get_processor_count( void )
+{
+    long count;
+    
+    count = sysconf( _SC_NPROCESSORS_ONLN );
+    
+    if( count < 1 )
+    {
+        return 1;
+    }
+    
+    return ( count > EGZ_THREADS_MAX ) ? EGZ_THREADS_MAX : ( unsigned int )count;
+}
+
+/*!
+ * 
+ */
+static void * egz_pool_worker( void * pool_ptr )
+{
+    egz_pool   * pool;
+    egz_job    * job;
+    egz_status   status;
+    
+    pool = ( egz_pool * )pool_ptr;
+    
+    pthread_mutex_lock( &( pool->mutex ) );
+    
+    while( 1 )
+    {
+        /* Waits for a submitted job */
+        while( pool->stop == false && pool->next_work == pool->next_submit )
+        {
+            pthread_cond_wait( &( pool->work ), &( pool->mutex ) );
+        }
+        
+        if( pool->stop == true )
+        {
+            break;
+        }
+        
+        job        = &( pool->jobs[ pool->next_work % pool->job_count ] );
+        job->state = EGZ_JOB_RUNNING;
+        
+        pool->next_work++;
+        
+        /* The job is processed without the lock */
+        pthread_mutex_unlock( &( pool->mutex ) );
+        
+        status = pool->function( job, pool->context );
+        
+        pthread_mutex_lock( &( pool->mutex ) );
+        
+        job->status = status;
+        job->state  = EGZ_JOB_DONE;
+        
+        pthread_cond_broadcast( &( pool->done ) );
+    }
+    
+    pthread_mutex_unlock( &( pool->mutex ) );
+    
+    return NULL;
+}
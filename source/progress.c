@@ -0,0 +1,351 @@
+/*******************************************************************************
+ * Copyright (c) 2010, Jean-David Gadina - www.xs-labs.com
+ * Distributed under the Boost Software License, Version 1.0.
+ * 
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ * 
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ * 
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ******************************************************************************/
+
+/* $Id$ */
+
+/*!
+ * @file        progress.c
+ * @copyright   (c) 2011 - Jean-David Gadina - www.xs-labs.com
+ * @abstract    Progress of the current stage
+ */
+
+/* Local includes */
+#include "egz.h"
+
+/* System includes */
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+
+/* Private variables */
+static bool                __ready   = false;
+static pthread_t           __owner;
+static int                 __fd      = -1;
+static bool                __off     = false;
+static bool                __bar_on  = false;
+static unsigned int        __stage   = 0;
+static unsigned int        __percent = 0;
+static uint64_t            __done    = 0;
+static uint64_t            __total   = 0;
+static double              __start   = 0;
+static double              __last    = 0;
+static libprogressbar_args __bar;
+static const char        * __names[ EGZ_PROGRESS_STAGES ] =
+{
+    "analyze",
+    "compress",
+    "expand",
+    "files"
+};
+static const char        * __labels[ EGZ_PROGRESS_STAGES ] =
+{
+    "Analyzing source file: ",
+    "Compressing file:      ",
+    "Expanding file:        ",
+    "Processing files:      "
+};
+
+/* The counters may be read from another thread than the one running the stage (GCC/Clang builtins, as the code is C99) */
+#define EGZ_PROGRESS_LOAD( _v_ )        __atomic_load_n( &( _v_ ), __ATOMIC_RELAXED )
+#define EGZ_PROGRESS_STORE( _v_, _n_ )  __atomic_store_n( &( _v_ ), ( _n_ ), __ATOMIC_RELAXED )
+
+/* Private functions */
+static bool   egz_progress_is_owner( void );
+static double egz_progress_clock( void );
+static void   egz_progress_write( double now );
+
+/*!
+ * 
+ */
+void egz_progress_init( void )
+{
+    __ready = true;
+    __owner = pthread_self();
+}
+
+/*!
+ * 
+ */
+bool egz_progress_open( int fd )
+{
+    if( fd < 0 || fcntl( fd, F_GETFD ) == -1 )
+    {
+        return false;
+    }
+    
+    /* A reader closing its end of a pipe must not kill the process - The write fails with EPIPE instead */
+    signal( SIGPIPE, SIG_IGN );
+    
+    __fd = fd;
+    
+    return true;
+}
+
+/*!
+ * 
+ */
+bool egz_progress_is_enabled( void )
+{
+    return ( __fd >= 0 ) ? true : false;
+}
+
+/*!
+ * 
+ */
+void egz_progress_begin( unsigned int stage, uint64_t total )
+{
+    /* No progress at all once the descriptor was dropped - Not even the terminal bar */
+    if( egz_progress_is_owner() == false || __off == true )
+    {
+        return;
+    }
+    
+    EGZ_PROGRESS_STORE( __stage,   ( stage < EGZ_PROGRESS_STAGES ) ? stage : 0 );
+    EGZ_PROGRESS_STORE( __percent, 0 );
+    EGZ_PROGRESS_STORE( __done,    0 );
+    EGZ_PROGRESS_STORE( __total,   total );
+    
+    /* The terminal bar would only be noise for a program reading the descriptor */
+    if( __fd >= 0 )
+    {
+        __start = egz_progress_clock();
+        __last  = __start;
+        
+        egz_progress_write( __start );
+    }
+    else if( libdebug_is_enabled() == false )
+    {
+        __bar.percent = &__percent;
+        __bar.length  = 50;
+        __bar.label   = ( char * )__labels[ EGZ_PROGRESS_LOAD( __stage ) ];
+        __bar.done    = "[OK]";
+        __bar_on      = true;
+        
+        libprogressbar_create_progressbar( ( void * )( &__bar ) );
+    }
+}
+
+/*!
+ * 
+ */
+void egz_progress_update( uint64_t done )
+{
+    double   now;
+    uint64_t total;
+    
+    if( egz_progress_is_owner() == false || __off == true )
+    {
+        return;
+    }
+    
+    EGZ_PROGRESS_STORE( __done, done );
+    
+    total = EGZ_PROGRESS_LOAD( __total );
+    
+    /* Integer math - The total is unknown (0) for the streams */
+    if( total > 0 && done <= total )
+    {
+        EGZ_PROGRESS_STORE( __percent, ( unsigned int )( ( done * 100 ) / total ) );
+    }
+    
+    if( __fd < 0 )
+    {
+        return;
+    }
+    
+    now = egz_progress_clock();
+    
+    /* Rate limited, so the reader is not flooded with small blocks */
+    if( now - __last >= EGZ_PROGRESS_INTERVAL )
+    {
+        __last = now;
+        
+        egz_progress_write( now );
+    }
+}
+
+/*!
+ * 
+ */
+void egz_progress_end( void )
+{
+    uint64_t total;
+    uint64_t done;
+    
+    if( egz_progress_is_owner() == false || __off == true )
+    {
+        return;
+    }
+    
+    EGZ_PROGRESS_STORE( __percent, 100 );
+    
+    if( __fd >= 0 )
+    {
+        total = EGZ_PROGRESS_LOAD( __total );
+        done  = EGZ_PROGRESS_LOAD( __done );
+        
+        /* The total of a stream is known once it is done */
+        total = ( total > done ) ? total : done;
+        
+        EGZ_PROGRESS_STORE( __total, total );
+        EGZ_PROGRESS_STORE( __done,  total );
+        
+        egz_progress_write( egz_progress_clock() );
+    }
+    else if( __bar_on == true )
+    {
+        __bar_on = false;
+        
+        libprogressbar_end();
+    }
+}
+
+/*!
+ * 
+ */
+bool egz_get_progress_fd( char * value, int * fd )
+{
+    char * end;
+    long   number;
+    
+    if( value == NULL || value[ 0 ] == 0 )
+    {
+        return false;
+    }
+    
+    number = strtol( value, &end, 10 );
+    
+    if( *( end ) != 0 || number < 0 || number > INT_MAX )
+    {
+        return false;
+    }
+    
+    *( fd ) = ( int )number;
+    
+    return true;
+}
+
+/*!
+ * 
+ */
+static bool egz_progress_is_owner( void )
+{
+    /* Files processed in parallel do not report their stages - The batch reports the files instead */
+    return ( __ready == true && pthread_equal( pthread_self(), __owner ) != 0 ) ? true : false;
+}
+
+/*!
+ * 
+ */
+static double egz_progress_clock( void )
+{
+    struct timespec time;
+    
+    if( clock_gettime( CLOCK_MONOTONIC, &time ) != 0 )
+    {
+        return 0;
+    }
+    
+    return ( double )time.tv_sec + ( double )time.tv_nsec / 1000000000.0;
+}
+
+/*!
+ * 
+ */
+static void egz_progress_write( double now )
+{
+    char     line[ EGZ_PROGRESS_LINE_LENGTH ];
+    char     eta[ 32 ];
+    double   elapsed;
+    double   rate;
+    int      length;
+    ssize_t  written;
+    char   * p;
+    uint64_t done;
+    uint64_t total;
+    
+    done    = EGZ_PROGRESS_LOAD( __done );
+    total   = EGZ_PROGRESS_LOAD( __total );
+    elapsed = now - __start;
+    rate    = ( elapsed > 0 ) ? ( double )done / elapsed : 0;
+    
+    /* No estimate without a total or a rate yet */
+    if( total > 0 && rate > 0 )
+    {
+        snprintf( eta, sizeof( eta ), "%.3f", ( double )( total - done ) / rate );
+    }
+    else
+    {
+        snprintf( eta, sizeof( eta ), "null" );
+    }
+    
+    length = snprintf
+    (
+        line,
+        sizeof( line ),
+        "{\"stage\": \"%s\", \"bytes_done\": %llu, \"bytes_total\": %llu, \"rate\": %.0f, \"elapsed\": %.3f, \"eta\": %s}\n",
+        __names[ EGZ_PROGRESS_LOAD( __stage ) ],
+        ( unsigned long long )done,
+        ( unsigned long long )total,
+        rate,
+        elapsed,
+        eta
+    );
+    
+    if( length < 0 || ( size_t )length >= sizeof( line ) )
+    {
+        return;
+    }
+    
+    p = line;
+    
+    while( length > 0 )
+    {
+        written = write( __fd, p, ( size_t )length );
+        
+        if( written < 0 && errno == EINTR )
+        {
+            continue;
+        }
+        
+        /* The reader went away - The work goes on without any progress */
+        if( written <= 0 )
+        {
+            __fd  = -1;
+            __off = true;
+            break;
+        }
+        
+        p      += written;
+        length -= ( int )written;
+    }
+}
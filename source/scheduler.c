@@ -0,0 +1,293 @@
+/*******************************************************************************
+ * Copyright (c) 2010, Jean-David Gadina - www.xs-labs.com
+ * Distributed under the Boost Software License, Version 1.0.
+ * 
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ * 
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ * 
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ******************************************************************************/
+
+/* $Id$ */
+
+/*!
+ * @file        scheduler.c
+ * @copyright   (c) 2011 - Jean-David Gadina - www.xs-labs.com
+ * @abstract    Work-stealing task scheduler
+ */
+
+/* Local includes */
+#include "egz.h"
+
+/* Private functions */
+static void     * egz_scheduler_worker( void * worker_ptr );
+static egz_task * egz_scheduler_next( egz_worker * worker );
+static int        egz_scheduler_compare( const void * task1_ptr, const void * task2_ptr );
+
+/*!
+ * 
+ */
+egz_scheduler * egz_scheduler_create( egz_task * tasks, size_t count, unsigned int threads, egz_task_function function, void * context )
+{
+    size_t          i;
+    size_t          start;
+    unsigned int    w;
+    egz_scheduler * scheduler;
+    egz_task     ** sorted;
+    
+    if( threads == 0 )
+    {
+        return NULL;
+    }
+    
+    /* No need for more workers than tasks */
+    threads = ( count > 0 && count < threads ) ? ( unsigned int )count : threads;
+    
+    if( NULL == ( scheduler = ( egz_scheduler * )calloc( 1, sizeof( egz_scheduler ) ) ) )
+    {
+        return NULL;
+    }
+    
+    scheduler->task_count = count;
+    scheduler->function   = function;
+    scheduler->context    = context;
+    scheduler->order      = ( egz_task ** )calloc( ( count > 0 ) ? count : 1, sizeof( egz_task * ) );
+    scheduler->completed  = ( egz_task ** )calloc( ( count > 0 ) ? count : 1, sizeof( egz_task * ) );
+    scheduler->workers    = ( egz_worker * )calloc( threads, sizeof( egz_worker ) );
+    sorted                = ( egz_task ** )calloc( ( count > 0 ) ? count : 1, sizeof( egz_task * ) );
+    
+    if( scheduler->order == NULL || scheduler->completed == NULL || scheduler->workers == NULL || sorted == NULL )
+    {
+        free( scheduler->order );
+        free( scheduler->completed );
+        free( scheduler->workers );
+        free( scheduler );
+        free( sorted );
+        return NULL;
+    }
+    
+    /* The largest tasks start first, so a huge one does not end up last on a single worker */
+    for( i = 0; i < count; i++ )
+    {
+        sorted[ i ] = &( tasks[ i ] );
+    }
+    
+    qsort( sorted, count, sizeof( egz_task * ), egz_scheduler_compare );
+    
+    pthread_mutex_init( &( scheduler->mutex ), NULL );
+    pthread_cond_init( &( scheduler->done ), NULL );
+    
+    /* The tasks are dealt in turn - Each worker gets a contiguous slice of the order, largest first */
+    for( w = 0, start = 0; w < threads; w++ )
+    {
+        scheduler->workers[ w ].index         = w;
+        scheduler->workers[ w ].scheduler     = scheduler;
+        scheduler->workers[ w ].deque.tasks   = scheduler->order + start;
+        scheduler->workers[ w ].deque.head    = 0;
+        scheduler->workers[ w ].deque.tail    = count / threads + ( ( w < count % threads ) ? 1 : 0 );
+        
+        for( i = 0; i < scheduler->workers[ w ].deque.tail; i++ )
+        {
+            scheduler->workers[ w ].deque.tasks[ i ] = sorted[ w + i * threads ];
+        }
+        
+        start += scheduler->workers[ w ].deque.tail;
+        
+        pthread_mutex_init( &( scheduler->workers[ w ].deque.mutex ), NULL );
+    }
+    
+    free( sorted );
+    
+    scheduler->worker_count = threads;
+    
+    for( w = 0, i = 0; w < threads; w++ )
+    {
+        /* A worker that cannot start leaves its tasks to the others */
+        if( pthread_create( &( scheduler->workers[ w ].thread ), NULL, egz_scheduler_worker, &( scheduler->workers[ w ] ) ) == 0 )
+        {
+            scheduler->workers[ w ].running = true;
+            
+            i++;
+        }
+    }
+    
+    /* No worker at all - Nothing would ever be processed */
+    if( i == 0 )
+    {
+        egz_scheduler_destroy( scheduler );
+        return NULL;
+    }
+    
+    return scheduler;
+}
+
+/*!
+ * 
+ */
+void egz_scheduler_destroy( egz_scheduler * scheduler )
+{
+    unsigned int i;
+    
+    /* The workers stop once every deque is empty */
+    for( i = 0; i < scheduler->worker_count; i++ )
+    {
+        if( scheduler->workers[ i ].running == true )
+        {
+            pthread_join( scheduler->workers[ i ].thread, NULL );
+        }
+        
+        pthread_mutex_destroy( &( scheduler->workers[ i ].deque.mutex ) );
+    }
+    
+    pthread_mutex_destroy( &( scheduler->mutex ) );
+    pthread_cond_destroy( &( scheduler->done ) );
+    
+    free( scheduler->workers );
+    free( scheduler->order );
+    free( scheduler->completed );
+    free( scheduler );
+}
+
+/*!
+ * 
+ */
+egz_task * egz_scheduler_collect( egz_scheduler * scheduler )
+{
+    egz_task * task;
+    
+    pthread_mutex_lock( &( scheduler->mutex ) );
+    
+    /* Everything was collected */
+    if( scheduler->collected == scheduler->task_count )
+    {
+        pthread_mutex_unlock( &( scheduler->mutex ) );
+        
+        return NULL;
+    }
+    
+    /* Results are collected in the completion order */
+    while( scheduler->collected == scheduler->completed_count )
+    {
+        pthread_cond_wait( &( scheduler->done ), &( scheduler->mutex ) );
+    }
+    
+    task = scheduler->completed[ scheduler->collected++ ];
+    
+    pthread_mutex_unlock( &( scheduler->mutex ) );
+    
+    return task;
+}
+
+/*!
+ * 
+ */
+static void * egz_scheduler_worker( void * worker_ptr )
+{
+    egz_worker    * worker;
+    egz_scheduler * scheduler;
+    egz_task      * task;
+    egz_status      status;
+    
+    worker    = ( egz_worker * )worker_ptr;
+    scheduler = worker->scheduler;
+    
+    /* Each task is a whole file, so its stages are timed in the worker */
+    egz_stats_attach();
+    
+    while( NULL != ( task = egz_scheduler_next( worker ) ) )
+    {
+        status = scheduler->function( task, scheduler->context );
+        
+        pthread_mutex_lock( &( scheduler->mutex ) );
+        
+        task->status = status;
+        
+        scheduler->completed[ scheduler->completed_count++ ] = task;
+        
+        pthread_cond_signal( &( scheduler->done ) );
+        pthread_mutex_unlock( &( scheduler->mutex ) );
+    }
+    
+    return NULL;
+}
+
+/*!
+ * 
+ */
+static egz_task * egz_scheduler_next( egz_worker * worker )
+{
+    unsigned int    i;
+    egz_deque     * deque;
+    egz_task      * task;
+    egz_scheduler * scheduler;
+    
+    task      = NULL;
+    scheduler = worker->scheduler;
+    deque     = &( worker->deque );
+    
+    /* Own tasks first, from the largest */
+    pthread_mutex_lock( &( deque->mutex ) );
+    
+    if( deque->head < deque->tail )
+    {
+        task = deque->tasks[ deque->head++ ];
+    }
+    
+    pthread_mutex_unlock( &( deque->mutex ) );
+    
+    /* Then steals from the other end of the next deques, so the owner and the thief rarely want the same task */
+    for( i = 1; task == NULL && i < scheduler->worker_count; i++ )
+    {
+        deque = &( scheduler->workers[ ( worker->index + i ) % scheduler->worker_count ].deque );
+        
+        pthread_mutex_lock( &( deque->mutex ) );
+        
+        if( deque->head < deque->tail )
+        {
+            task = deque->tasks[ --deque->tail ];
+        }
+        
+        pthread_mutex_unlock( &( deque->mutex ) );
+    }
+    
+    /* No task is ever added - Every deque is empty, so the worker is done */
+    return task;
+}
+
+/*!
+ * 
+ */
+static int egz_scheduler_compare( const void * task1_ptr, const void * task2_ptr )
+{
+    egz_task * task1;
+    egz_task * task2;
+    
+    task1 = *( ( egz_task ** )task1_ptr );
+    task2 = *( ( egz_task ** )task2_ptr );
+    
+    if( task1->size == task2->size )
+    {
+        return 0;
+    }
+    
+    return ( task1->size > task2->size ) ? -1 : 1;
+}
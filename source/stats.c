@@ -0,0 +1,318 @@
+/*******************************************************************************
+ * Copyright (c) 2010, Jean-David Gadina - www.xs-labs.com
+ * Distributed under the Boost Software License, Version 1.0.
+ * 
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ * 
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ * 
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ******************************************************************************/
+
+/* $Id$ */
+
+/*!
+ * @file        stats.c
+ * @copyright   (c) 2011 - Jean-David Gadina - www.xs-labs.com
+ * @abstract    Per-stage timing statistics
+ */
+
+/* Local includes */
+#include "egz.h"
+
+/* System includes */
+#include <time.h>
+
+/* Private variables */
+static bool              __enabled = false;
+static pthread_t         __owner;
+static pthread_mutex_t   __mutex   = PTHREAD_MUTEX_INITIALIZER;
+static egz_stage         __stages[ EGZ_STATS_STAGES ];
+static egz_timer         __total;
+static const char      * __names[ EGZ_STATS_STAGES ] =
+{
+    "histogram",
+    "tree",
+    "codes",
+    "header",
+    "encode",
+    "checksum",
+    "parse",
+    "rebuild",
+    "decode",
+    "verify"
+};
+
+/* Per thread, as the scheduler workers time their own stages (GCC/Clang extension, as the code is C99) */
+static __thread bool     __attached    = false;
+static __thread double   __nested_wall = 0;
+static __thread double   __nested_cpu  = 0;
+
+/* Private functions */
+static bool   egz_stats_is_timed( void );
+static double egz_stats_cpu( void );
+static double egz_stats_clock( clockid_t clock );
+static double egz_stats_throughput( egz_stage * stage );
+
+/*!
+ * 
+ */
+void egz_stats_enable( void )
+{
+    memset( __stages, 0, sizeof( __stages ) );
+    
+    __enabled     = true;
+    __owner       = pthread_self();
+    __nested_wall = 0;
+    __nested_cpu  = 0;
+    
+    egz_stats_begin( &__total );
+}
+
+/*!
+ * 
+ */
+void egz_stats_attach( void )
+{
+    if( __enabled == false )
+    {
+        return;
+    }
+    
+    __attached    = true;
+    __nested_wall = 0;
+    __nested_cpu  = 0;
+}
+
+/*!
+ * 
+ */
+void egz_stats_begin( egz_timer * timer )
+{
+    if( egz_stats_is_timed() == false )
+    {
+        return;
+    }
+    
+    timer->wall        = egz_stats_clock( CLOCK_MONOTONIC );
+    timer->cpu         = egz_stats_cpu();
+    timer->nested_wall = __nested_wall;
+    timer->nested_cpu  = __nested_cpu;
+}
+
+/*!
+ * 
+ */
+void egz_stats_end( egz_timer * timer, unsigned int stage, uint64_t bytes_in, uint64_t bytes_out )
+{
+    double wall;
+    double cpu;
+    
+    if( egz_stats_is_timed() == false || stage >= EGZ_STATS_STAGES )
+    {
+        return;
+    }
+    
+    wall = egz_stats_clock( CLOCK_MONOTONIC ) - timer->wall;
+    cpu  = egz_stats_cpu()                    - timer->cpu;
+    
+    /* Several scheduler workers may end a stage at the same time */
+    pthread_mutex_lock( &__mutex );
+    
+    /* Stages may be nested (the checksum is computed while reading) - Each one only gets its own time */
+    __stages[ stage ].wall      += wall - ( __nested_wall - timer->nested_wall );
+    __stages[ stage ].cpu       += cpu  - ( __nested_cpu  - timer->nested_cpu );
+    __stages[ stage ].bytes_in  += bytes_in;
+    __stages[ stage ].bytes_out += bytes_out;
+    __stages[ stage ].calls     += 1;
+    
+    pthread_mutex_unlock( &__mutex );
+    
+    /* The enclosing stage will not count this time */
+    __nested_wall = timer->nested_wall + wall;
+    __nested_cpu  = timer->nested_cpu  + cpu;
+}
+
+/*!
+ * 
+ */
+void egz_stats_print( FILE * stream, unsigned int format )
+{
+    unsigned int i;
+    unsigned int count;
+    double       wall;
+    double       cpu;
+    egz_stage  * stage;
+    
+    if( __enabled == false )
+    {
+        return;
+    }
+    
+    wall  = egz_stats_clock( CLOCK_MONOTONIC )          - __total.wall;
+    cpu   = egz_stats_clock( CLOCK_PROCESS_CPUTIME_ID ) - __total.cpu;
+    count = 0;
+    
+    if( format == EGZ_STATS_FORMAT_JSON )
+    {
+        fprintf( stream, "{\n    \"stages\":\n    [" );
+    }
+    else
+    {
+        fprintf( stream, "%-10s %8s %10s %10s %14s %14s %10s\n", "Stage", "Calls", "Wall (s)", "CPU (s)", "Bytes in", "Bytes out", "MB/s" );
+    }
+    
+    /* Stages that did not run are not printed */
+    for( i = 0; i < EGZ_STATS_STAGES; i++ )
+    {
+        stage = &( __stages[ i ] );
+        
+        if( stage->calls == 0 )
+        {
+            continue;
+        }
+        
+        if( format == EGZ_STATS_FORMAT_JSON )
+        {
+            fprintf
+            (
+                stream,
+                "%s\n"
+                "        {\n"
+                "            \"name\": \"%s\",\n"
+                "            \"calls\": %lu,\n"
+                "            \"wall_seconds\": %.6f,\n"
+                "            \"cpu_seconds\": %.6f,\n"
+                "            \"bytes_in\": %llu,\n"
+                "            \"bytes_out\": %llu,\n"
+                "            \"mbps\": %.2f\n"
+                "        }",
+                ( count > 0 ) ? "," : "",
+                __names[ i ],
+                stage->calls,
+                stage->wall,
+                stage->cpu,
+                ( unsigned long long )stage->bytes_in,
+                ( unsigned long long )stage->bytes_out,
+                egz_stats_throughput( stage )
+            );
+        }
+        else
+        {
+            fprintf
+            (
+                stream,
+                "%-10s %8lu %10.6f %10.6f %14llu %14llu %10.2f\n",
+                __names[ i ],
+                stage->calls,
+                stage->wall,
+                stage->cpu,
+                ( unsigned long long )stage->bytes_in,
+                ( unsigned long long )stage->bytes_out,
+                egz_stats_throughput( stage )
+            );
+        }
+        
+        count++;
+    }
+    
+    /* The total includes the time spent outside of the stages (opening the files, printing the progress) */
+    if( format == EGZ_STATS_FORMAT_JSON )
+    {
+        fprintf( stream, "\n    ],\n    \"wall_seconds\": %.6f,\n    \"cpu_seconds\": %.6f\n}\n", wall, cpu );
+    }
+    else
+    {
+        fprintf( stream, "%-10s %8s %10.6f %10.6f\n", "total", "", wall, cpu );
+    }
+}
+
+/*!
+ * 
+ */
+bool egz_get_stats_format( char * name, unsigned int * format )
+{
+    if( name == NULL || name[ 0 ] == 0 || strcmp( name, "text" ) == 0 )
+    {
+        *( format ) = EGZ_STATS_FORMAT_TEXT;
+    }
+    else if( strcmp( name, "json" ) == 0 )
+    {
+        *( format ) = EGZ_STATS_FORMAT_JSON;
+    }
+    else
+    {
+        return false;
+    }
+    
+    return true;
+}
+
+/*!
+ * 
+ */
+static bool egz_stats_is_timed( void )
+{
+    /* The thread that enabled the statistics, and the scheduler workers - The pool workers are part of the stage that waits for them */
+    return ( __enabled == true && ( __attached == true || pthread_equal( pthread_self(), __owner ) != 0 ) ) ? true : false;
+}
+
+/*!
+ * 
+ */
+static double egz_stats_cpu( void )
+{
+    /* A scheduler worker only counts its own file, not the ones processed at the same time */
+    return egz_stats_clock( ( __attached == true ) ? CLOCK_THREAD_CPUTIME_ID : CLOCK_PROCESS_CPUTIME_ID );
+}
+
+/*!
+ * 
+ */
+static double egz_stats_clock( clockid_t clock )
+{
+    struct timespec time;
+    
+    if( clock_gettime( clock, &time ) != 0 )
+    {
+        return 0;
+    }
+    
+    return ( double )time.tv_sec + ( double )time.tv_nsec / 1000000000.0;
+}
+
+/*!
+ * 
+ */
+static double egz_stats_throughput( egz_stage * stage )
+{
+    uint64_t bytes;
+    
+    /* The uncompressed side of the stage - Input when compressing, output when expanding */
+    bytes = ( stage->bytes_in > stage->bytes_out ) ? stage->bytes_in : stage->bytes_out;
+    
+    if( stage->wall <= 0 || bytes == 0 )
+    {
+        return 0;
+    }
+    
+    return ( ( double )bytes / 1000 / 1000 ) / stage->wall;
+}
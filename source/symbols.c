@@ -38,7 +38,9 @@
 /* Local includes */
 #include "egz.h"
 
-static unsigned int __percent = 0;
+/* Private functions */
+static void egz_count_lanes( uint32_t lanes[ EGZ_HISTOGRAM_LANES ][ 256 ], unsigned char * data, size_t length );
+static void egz_histogram_flush( egz_histogram * histogram );
 
 /*!
  * 
@@ -55,6 +57,7 @@ egz_table * egz_create_table( void )
     }
     
     /* Initializes the table fields */
+    table->id          = 0;
     table->count       = 0;
     table->total       = 0;
     table->information = 0;
@@ -63,13 +66,17 @@ egz_table * egz_create_table( void )
     /* Initializes each character fields */
     for( i = 0; i < 256; i++ )
     {
-        table->symbols[ i ].character  = ( unsigned char )i;
-        table->symbols[ i ].occurences = 0;
-        table->symbols[ i ].id         = 0;
-        table->symbols[ i ].entropy    = 0;
-        table->symbols[ i ].parent     = NULL;
-        table->symbols[ i ].left       = NULL;
-        table->symbols[ i ].right      = NULL;
+        table->symbols[ i ].character   = ( unsigned char )i;
+        table->symbols[ i ].occurences  = 0;
+        table->symbols[ i ].id          = 0;
+        table->symbols[ i ].bits        = 0;
+        table->symbols[ i ].code        = 0;
+        table->symbols[ i ].frequency   = 0;
+        table->symbols[ i ].information = 0;
+        table->symbols[ i ].entropy     = 0;
+        table->symbols[ i ].parent      = NULL;
+        table->symbols[ i ].left        = NULL;
+        table->symbols[ i ].right       = NULL;
     }
     
     return table;
@@ -78,69 +85,64 @@ egz_table * egz_create_table( void )
 /*!
  * 
  */
-void egz_get_symbols( egz_table * table, FILE * source )
+void egz_get_symbols( egz_table * table, FILE * source, egz_mapping * mapping, egz_digest * digest )
 {
-    unsigned int        i;
-    unsigned int        j;
-    unsigned char       buffer[ EGZ_READ_BUFFER_LENGTH ];
-    size_t              length;
-    long                offset;
-    unsigned long       size;
-    unsigned long       read_ops;
-    unsigned long       read_op;
-    libprogressbar_args args;
-    
-    __percent = 0;
-    size      = egz_getfilesize( source );
-    read_ops  = ceil( ( double )size / ( double )EGZ_READ_BUFFER_LENGTH );
-    read_op   = 0;
-    
-    if( libdebug_is_enabled() == false )
-    {
-        args.percent = &__percent;
-        args.length  = 50;
-        args.label   = "Analyzing source file: ";
-        args.done    = "[OK]";
-        
-        libprogressbar_create_progressbar( ( void * )( &args ) );
-    }
+    unsigned int    i;
+    unsigned char   buffer[ EGZ_READ_BUFFER_LENGTH ];
+    unsigned char * data;
+    size_t          length;
+    size_t          position;
+    long            offset;
+    unsigned long   size;
+    unsigned long   bytes;
+    egz_histogram   histogram;
+    
+    size     = egz_getfilesize( source );
+    bytes    = 0;
+    position = 0;
+    
+    egz_progress_begin( EGZ_PROGRESS_ANALYZE, size );
     
     offset = ftell( source );
     
     fseek( source, 0, SEEK_SET );
+    egz_histogram_begin( &histogram );
     
-    /* Reads the source file */
-    while( ( length = fread( buffer, sizeof( char ), EGZ_READ_BUFFER_LENGTH, source ) ) > 0 )
+    /* Reads the source file - The checksum is computed in the same pass */
+    while( 1 )
     {
-        read_op++;
+        /* Mapped file - The data is used in place */
+        if( mapping != NULL )
+        {
+            data      = mapping->data + position;
+            length    = ( mapping->length - position < EGZ_MAP_CHUNK_LENGTH ) ? mapping->length - position : EGZ_MAP_CHUNK_LENGTH;
+            position += length;
+        }
+        else
+        {
+            data   = buffer;
+            length = fread( buffer, sizeof( char ), EGZ_READ_BUFFER_LENGTH, source );
+        }
         
-        /* Process each byte read */
-        for( i = 0; i < length; i++ )
+        if( length == 0 )
         {
-            /* Character ASCII code */
-            j = buffer[ i ];
-            
-            /* Checks if the occurences of the symbol were already found */
-            if( table->symbols[ j ].occurences == 0 )
-            {
-                /* No - Increase the total number of symbols in the table */
-                table->count++;
-            }
-            
-            /* Increases the number of ocurrences */
-            table->symbols[ j ].occurences++;
-            table->total++;
+            break;
         }
         
-        if( read_ops > 1 )
+        bytes += length;
+        
+        if( digest != NULL )
         {
-            __percent = ( ( double )read_op / ( double )read_ops ) * 100;
+            egz_digest_update( digest, data, length );
         }
+        
+        egz_histogram_update( &histogram, data, length );
+        egz_progress_update( bytes );
     }
     
-    __percent = 100;
-    
-    libprogressbar_end();
+    /* The lanes are merged once, for the whole file */
+    egz_histogram_end( &histogram, table );
+    egz_progress_end();
     
     /* Process each symbol of the table */
     for( i = 0; i < 256; i++ )
@@ -166,6 +168,155 @@ void egz_get_symbols( egz_table * table, FILE * source )
     fseek( source, 0, SEEK_SET );
 }
 
+/*!
+ * 
+ */
+void egz_count_symbols( egz_table * table, unsigned char * data, size_t length )
+{
+    egz_histogram histogram;
+    
+    egz_histogram_begin( &histogram );
+    egz_histogram_update( &histogram, data, length );
+    egz_histogram_end( &histogram, table );
+}
+
+/*!
+ * 
+ */
+void egz_histogram_begin( egz_histogram * histogram )
+{
+    memset( histogram, 0, sizeof( egz_histogram ) );
+}
+
+/*!
+ * 
+ */
+void egz_histogram_update( egz_histogram * histogram, unsigned char * data, size_t length )
+{
+    size_t part;
+    
+    while( length > 0 )
+    {
+        /* The 32-bit lanes are merged before they can overflow */
+        if( histogram->pending == EGZ_HISTOGRAM_FLUSH_LENGTH )
+        {
+            egz_histogram_flush( histogram );
+        }
+        
+        part = ( length < EGZ_HISTOGRAM_FLUSH_LENGTH - histogram->pending ) ? length : EGZ_HISTOGRAM_FLUSH_LENGTH - histogram->pending;
+        
+        egz_count_lanes( histogram->lanes, data, part );
+        
+        histogram->pending += part;
+        data               += part;
+        length             -= part;
+    }
+}
+
+/*!
+ * 
+ */
+void egz_histogram_end( egz_histogram * histogram, egz_table * table )
+{
+    unsigned int i;
+    
+    egz_histogram_flush( histogram );
+    
+    for( i = 0; i < 256; i++ )
+    {
+        table->symbols[ i ].occurences += histogram->counts[ i ];
+    }
+    
+    /* The number of symbols and bytes are taken from the final histogram */
+    table->count = 0;
+    table->total = 0;
+    
+    for( i = 0; i < 256; i++ )
+    {
+        if( table->symbols[ i ].occurences > 0 )
+        {
+            table->count++;
+            table->total += table->symbols[ i ].occurences;
+        }
+    }
+}
+
+/*!
+ * 
+ */
+void egz_count_histogram( unsigned long * histogram, unsigned char * data, size_t length )
+{
+    unsigned int i;
+    size_t       part;
+    uint32_t     lanes[ EGZ_HISTOGRAM_LANES ][ 256 ];
+    
+    while( length > 0 )
+    {
+        /* The 32-bit lanes are merged before they can overflow */
+        part = ( length < EGZ_HISTOGRAM_FLUSH_LENGTH ) ? length : EGZ_HISTOGRAM_FLUSH_LENGTH;
+        
+        memset( lanes, 0, sizeof( lanes ) );
+        egz_count_lanes( lanes, data, part );
+        
+        for( i = 0; i < 256; i++ )
+        {
+            histogram[ i ] += ( unsigned long )lanes[ 0 ][ i ] + lanes[ 1 ][ i ] + lanes[ 2 ][ i ] + lanes[ 3 ][ i ];
+        }
+        
+        data   += part;
+        length -= part;
+    }
+}
+
+/*!
+ * 
+ */
+static void egz_histogram_flush( egz_histogram * histogram )
+{
+    unsigned int i;
+    
+    for( i = 0; i < 256; i++ )
+    {
+        histogram->counts[ i ] += ( unsigned long )histogram->lanes[ 0 ][ i ] + histogram->lanes[ 1 ][ i ] + histogram->lanes[ 2 ][ i ] + histogram->lanes[ 3 ][ i ];
+    }
+    
+    memset( histogram->lanes, 0, sizeof( histogram->lanes ) );
+    
+    histogram->pending = 0;
+}
+
+/*!
+ * 
+ */
+static void egz_count_lanes( uint32_t lanes[ EGZ_HISTOGRAM_LANES ][ 256 ], unsigned char * data, size_t length )
+{
+    size_t   i;
+    uint64_t word;
+    
+    /*
+     * Eight bytes per iteration, spread over four histograms, so runs of the
+     * same byte do not wait on the previous increment of the same counter
+     */
+    for( i = 0; i + 8 <= length; i += 8 )
+    {
+        memcpy( &word, data + i, sizeof( uint64_t ) );
+        
+        lanes[ 0 ][ ( word       ) & 0xFF ]++;
+        lanes[ 1 ][ ( word >>  8 ) & 0xFF ]++;
+        lanes[ 2 ][ ( word >> 16 ) & 0xFF ]++;
+        lanes[ 3 ][ ( word >> 24 ) & 0xFF ]++;
+        lanes[ 0 ][ ( word >> 32 ) & 0xFF ]++;
+        lanes[ 1 ][ ( word >> 40 ) & 0xFF ]++;
+        lanes[ 2 ][ ( word >> 48 ) & 0xFF ]++;
+        lanes[ 3 ][ ( word >> 56 )        ]++;
+    }
+    
+    for( ; i < length; i++ )
+    {
+        lanes[ i % EGZ_HISTOGRAM_LANES ][ data[ i ] ]++;
+    }
+}
+
 /*!
  * 
  */
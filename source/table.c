@@ -0,0 +1,303 @@
+/*******************************************************************************
+ * Copyright (c) 2010, Jean-David Gadina - www.xs-labs.com
+ * Distributed under the Boost Software License, Version 1.0.
+ * 
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ * 
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ * 
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ******************************************************************************/
+
+/* $Id$ */
+
+/*!
+ * @file        table.c
+ * @copyright   (c) 2011 - Jean-David Gadina - www.xs-labs.com
+ * @abstract    Pre-trained tables
+ */
+
+/* Local includes */
+#include "egz.h"
+
+/* Private functions */
+static uint64_t egz_hash_lengths( unsigned char * data, size_t length );
+
+/*!
+ * 
+ */
+egz_status egz_train_table( egz_table * table, char ** sources, unsigned int count, unsigned int max_code_bits )
+{
+    unsigned int  i;
+    size_t        length;
+    FILE        * source;
+    egz_symbol  * symbols[ 256 ];
+    egz_histogram histogram;
+    unsigned char buffer[ EGZ_READ_BUFFER_LENGTH ];
+    unsigned char packed[ 2 + 256 ];
+    
+    egz_histogram_begin( &histogram );
+    
+    /* The symbols of all the sample files are counted together */
+    for( i = 0; i < count; i++ )
+    {
+        if( NULL == ( source = fopen( sources[ i ], "rb" ) ) )
+        {
+            return EGZ_ERROR_FILE;
+        }
+        
+        while( ( length = fread( buffer, sizeof( unsigned char ), EGZ_READ_BUFFER_LENGTH, source ) ) > 0 )
+        {
+            egz_histogram_update( &histogram, buffer, length );
+        }
+        
+        fclose( source );
+    }
+    
+    egz_histogram_end( &histogram, table );
+    
+    if( table->total == 0 )
+    {
+        return EGZ_ERROR_EMPTY_FILE;
+    }
+    
+    /* Symbols missing from the samples still get a code, so any file can use the table */
+    for( i = 0; i < 256; i++ )
+    {
+        if( table->symbols[ i ].occurences == 0 )
+        {
+            table->symbols[ i ].occurences = 1;
+        }
+    }
+    
+    table->count = 256;
+    
+    if( egz_create_table_codes( table, symbols, max_code_bits ) == false )
+    {
+        return EGZ_ERROR_MALLOC;
+    }
+    
+    /* The table is identified by its code lengths */
+    egz_pack_lengths( table, packed );
+    
+    table->id = egz_hash_lengths( packed, egz_get_lengths_size( table ) );
+    
+    return EGZ_OK;
+}
+
+/*!
+ * 
+ */
+egz_status egz_save_table( egz_table * table, char * filename )
+{
+    size_t        length;
+    FILE        * destination;
+    unsigned char data[ EGZ_TABLE_FILE_MAX_LENGTH ];
+    
+    /* Signature, ID and code lengths */
+    memcpy( data, EGZ_TABLE_FILE_ID, strlen( EGZ_TABLE_FILE_ID ) );
+    memcpy( data + 3, &( table->id ), sizeof( uint64_t ) );
+    egz_pack_lengths( table, data + 11 );
+    
+    length = 11 + egz_get_lengths_size( table );
+    
+    if( NULL == ( destination = fopen( filename, "wb" ) ) )
+    {
+        return EGZ_ERROR_FILE;
+    }
+    
+    if( fwrite( data, sizeof( unsigned char ), length, destination ) != length )
+    {
+        fclose( destination );
+        return EGZ_ERROR_FILE;
+    }
+    
+    return ( fclose( destination ) == 0 ) ? EGZ_OK : EGZ_ERROR_FILE;
+}
+
+/*!
+ * 
+ */
+egz_status egz_load_table( egz_table * table, char * filename )
+{
+    unsigned int  i;
+    size_t        length;
+    uint64_t      id;
+    FILE        * source;
+    unsigned char lengths[ 256 ];
+    unsigned char data[ EGZ_TABLE_FILE_MAX_LENGTH + 1 ];
+    
+    if( NULL == ( source = fopen( filename, "rb" ) ) )
+    {
+        return EGZ_ERROR_FILE;
+    }
+    
+    length = fread( data, sizeof( unsigned char ), EGZ_TABLE_FILE_MAX_LENGTH + 1, source );
+    
+    fclose( source );
+    
+    if( length < 11 + 2 || length > EGZ_TABLE_FILE_MAX_LENGTH || memcmp( data, EGZ_TABLE_FILE_ID, strlen( EGZ_TABLE_FILE_ID ) ) != 0 )
+    {
+        return EGZ_ERROR_INVALID_FORMAT;
+    }
+    
+    memcpy( &id, data + 3, sizeof( uint64_t ) );
+    
+    /* A damaged table would decode garbage - The ID must match the code lengths */
+    if( id != egz_hash_lengths( data + 11, length - 11 ) || egz_rebuild_lengths( data + 11, lengths, ( uint16_t )( length - 11 ) ) == 0 )
+    {
+        return EGZ_ERROR_INVALID_FORMAT;
+    }
+    
+    table->id    = id;
+    table->count = 0;
+    
+    for( i = 0; i < 256; i++ )
+    {
+        if( lengths[ i ] > EGZ_BTREE_CODE_MAX_LENGTH )
+        {
+            return EGZ_ERROR_INVALID_FORMAT;
+        }
+        
+        table->symbols[ i ].bits = lengths[ i ];
+        table->count            += ( lengths[ i ] > 0 ) ? 1 : 0;
+    }
+    
+    egz_create_canonical_codes( table );
+    
+    return EGZ_OK;
+}
+
+/*!
+ * 
+ */
+egz_status egz_find_table( egz_table * table, uint64_t id, char * filename )
+{
+    char            * path;
+    char            * directory;
+    char            * next;
+    DIR             * dir;
+    struct dirent   * entry;
+    size_t            length;
+    char              candidate[ FILENAME_MAX ];
+    char              paths[ FILENAME_MAX ];
+    
+    /* The table given on the command line comes first */
+    if( filename != NULL && egz_load_table( table, filename ) == EGZ_OK && table->id == id )
+    {
+        return EGZ_OK;
+    }
+    
+    path = getenv( EGZ_TABLE_PATH_ENV );
+    
+    strncpy( paths, ( path != NULL && path[ 0 ] != 0 ) ? path : EGZ_TABLE_PATH_DEFAULT, FILENAME_MAX - 1 );
+    
+    paths[ FILENAME_MAX - 1 ] = 0;
+    
+    /* Then every table file of the search path directories */
+    for( directory = paths; directory != NULL; directory = next )
+    {
+        if( NULL != ( next = strchr( directory, ':' ) ) )
+        {
+            *( next++ ) = 0;
+        }
+        
+        if( NULL == ( dir = opendir( ( directory[ 0 ] != 0 ) ? directory : EGZ_TABLE_PATH_DEFAULT ) ) )
+        {
+            continue;
+        }
+        
+        while( NULL != ( entry = readdir( dir ) ) )
+        {
+            length = strlen( entry->d_name );
+            
+            if( length <= strlen( EGZ_TABLE_FILE_EXT ) || strcmp( entry->d_name + length - strlen( EGZ_TABLE_FILE_EXT ), EGZ_TABLE_FILE_EXT ) != 0 )
+            {
+                continue;
+            }
+            
+            if( snprintf( candidate, FILENAME_MAX, "%s/%s", ( directory[ 0 ] != 0 ) ? directory : EGZ_TABLE_PATH_DEFAULT, entry->d_name ) >= FILENAME_MAX )
+            {
+                continue;
+            }
+            
+            if( egz_load_table( table, candidate ) == EGZ_OK && table->id == id )
+            {
+                closedir( dir );
+                return EGZ_OK;
+            }
+        }
+        
+        closedir( dir );
+    }
+    
+    return EGZ_ERROR_TABLE_NOT_FOUND;
+}
+
+/*!
+ * 
+ */
+egz_status egz_find_table_lookup( egz_lookup ** lookup_ptr, uint64_t id, char * filename )
+{
+    unsigned int  i;
+    egz_table   * table;
+    egz_status    status;
+    unsigned char lengths[ 256 ];
+    
+    if( NULL == ( table = egz_create_table() ) )
+    {
+        return EGZ_ERROR_MALLOC;
+    }
+    
+    if( EGZ_OK == ( status = egz_find_table( table, id, filename ) ) )
+    {
+        for( i = 0; i < 256; i++ )
+        {
+            lengths[ i ] = ( unsigned char )table->symbols[ i ].bits;
+        }
+        
+        status = egz_create_canonical_lookup( lookup_ptr, lengths );
+    }
+    
+    free( table );
+    
+    return status;
+}
+
+/*!
+ * 
+ */
+static uint64_t egz_hash_lengths( unsigned char * data, size_t length )
+{
+    size_t   i;
+    uint64_t hash;
+    
+    /* FNV-1a - Zero is kept for the tables without ID */
+    hash = 0xCBF29CE484222325ULL;
+    
+    for( i = 0; i < length; i++ )
+    {
+        hash ^= data[ i ];
+        hash *= 0x100000001B3ULL;
+    }
+    
+    return ( hash != 0 ) ? hash : 1;
+}
@@ -0,0 +1,132 @@
+/*******************************************************************************
+ * Copyright (c) 2010, Jean-David Gadina - www.xs-labs.com
+ * Distributed under the Boost Software License, Version 1.0.
+ * 
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ * 
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ * 
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ******************************************************************************/
+
+/* $Id$ */
+
+/*!
+ * @file        trace.c
+ * @copyright   (c) 2011 - Jean-David Gadina - www.xs-labs.com
+ * @abstract    Compile-time trace events
+ */
+
+/* Local includes */
+#include "egz.h"
+
+#if EGZ_TRACE_LEVEL > EGZ_TRACE_LEVEL_NONE
+
+/* Private variables */
+static egz_trace_event __events[ EGZ_TRACE_BUFFER_LENGTH ];
+static uint64_t        __sequence = 0;
+static pthread_mutex_t __mutex    = PTHREAD_MUTEX_INITIALIZER;
+static const char    * __names[ EGZ_TRACE_EVENTS ] =
+{
+    "block-compressed",
+    "block-expanded",
+    "block-codes",
+    "block-stored",
+    "tree-symbol",
+    "tree-branch",
+    "tree-node",
+    "tree-leaf"
+};
+
+/*!
+ * 
+ */
+void egz_trace_record( unsigned int event, const char * file, unsigned int line, uint64_t a, uint64_t b, uint64_t c )
+{
+    egz_trace_event * entry;
+    
+    /* Block events come from the worker threads as well */
+    pthread_mutex_lock( &__mutex );
+    
+    /* The oldest events are overwritten once the buffer is full */
+    entry = &( __events[ __sequence % EGZ_TRACE_BUFFER_LENGTH ] );
+    
+    entry->sequence  = __sequence++;
+    entry->file      = file;
+    entry->line      = line;
+    entry->event     = event;
+    entry->args[ 0 ] = a;
+    entry->args[ 1 ] = b;
+    entry->args[ 2 ] = c;
+    
+    pthread_mutex_unlock( &__mutex );
+}
+
+#endif
+
+/*!
+ * 
+ */
+unsigned long egz_trace_dump( FILE * stream )
+{
+    #if EGZ_TRACE_LEVEL > EGZ_TRACE_LEVEL_NONE
+    
+    uint64_t          i;
+    uint64_t          first;
+    egz_trace_event * entry;
+    
+    pthread_mutex_lock( &__mutex );
+    
+    first = ( __sequence > EGZ_TRACE_BUFFER_LENGTH ) ? __sequence - EGZ_TRACE_BUFFER_LENGTH : 0;
+    
+    fprintf( stream, "Trace: %llu event(s), last %llu:\n", ( unsigned long long )__sequence, ( unsigned long long )( __sequence - first ) );
+    
+    for( i = first; i < __sequence; i++ )
+    {
+        entry = &( __events[ i % EGZ_TRACE_BUFFER_LENGTH ] );
+        
+        fprintf
+        (
+            stream,
+            "    #%-8llu %-16s %20llu %20llu %20llu    (%s:%u)\n",
+            ( unsigned long long )entry->sequence,
+            ( entry->event < EGZ_TRACE_EVENTS ) ? __names[ entry->event ] : "unknown",
+            ( unsigned long long )entry->args[ 0 ],
+            ( unsigned long long )entry->args[ 1 ],
+            ( unsigned long long )entry->args[ 2 ],
+            ( strrchr( entry->file, '/' ) != NULL ) ? strrchr( entry->file, '/' ) + 1 : entry->file,
+            entry->line
+        );
+    }
+    
+    pthread_mutex_unlock( &__mutex );
+    
+    return ( unsigned long )( __sequence - first );
+    
+    #else
+    
+    /* Release build - Nothing was recorded */
+    ( void )stream;
+    
+    return 0;
+    
+    #endif
+}